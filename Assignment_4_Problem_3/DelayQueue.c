@@ -0,0 +1,422 @@
+//
+//  DelayQueue.c - a hierarchical timer wheel keyed by deadline
+//
+//  A node is kept at the level of the highest WHEELBITS-wide digit in
+//  which its deadline differs from the wheel's clock, in the slot given by
+//  its deadline's digit at that level.  So every node at level k shares the
+//  clock's digits above k and is due in a later level k slot than the
+//  clock's.  Level 0 slots are single milliseconds and are handed back as
+//  the clock passes them; when the clock reaches the start of a higher
+//  level slot, that slot's nodes are placed again and drop to lower levels.
+//
+
+#ifndef _WIN32
+// clock_gettime and nanosleep are POSIX calls
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+// stdlib provides malloc and free
+#include <stdlib.h>
+// stdbool defines bool
+#include <stdbool.h>
+// asserts are used for checking that the queue and handles exist
+#include <assert.h>
+// calls the delay queue supports are included for consistency checking
+#include "DelayQueue.h"
+// AllocationCount is declared with the linked list code
+#include "LinkedList.h"
+#ifdef _WIN32
+// GetTickCount64 and Sleep
+#include <windows.h>
+#else
+// clock_gettime and nanosleep
+#include <time.h>
+// errno tells us nanosleep was interrupted
+#include <errno.h>
+#endif
+
+// SLOTMASK picks the slot digit out of a shifted deadline
+#define SLOTMASK (WHEELSLOTS - 1)
+
+// local function Place links a node into the slot (or overflow list)
+// its deadline belongs in relative to the wheel's clock
+static void Place      (DelayQueue DQ, DelayHandle H);
+// local function Unlink takes a node out of its slot's list
+static void Unlink     (DelayQueue DQ, DelayHandle H);
+// local function NextBlock finds the earliest occupied slot above level 0
+static bool NextBlock  (DelayQueue DQ, long long *Start, int *Level);
+// local function Cascade places again every node of one slot
+static void Cascade    (DelayQueue DQ, int Level, int Slot);
+// local function ExpireSlot hands back every node of a level 0 slot
+static int  ExpireSlot (DelayQueue DQ, int Slot, Queue Due);
+// local functions LowestBit and HighestBit return the index of the lowest
+// and highest set bit in a non-zero bitmap
+static int  LowestBit  (unsigned long long Bits);
+static int  HighestBit (unsigned long long Bits);
+
+/*
+ currentMillis() reads the system's monotonic clock, which is not changed
+ when the time of day is set, and returns it in milliseconds
+*/
+long long currentMillis (void)
+{
+#ifdef _WIN32
+    return (long long) GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/*
+ sleepUntil() gives up the processor until the monotonic clock reaches
+ When, rather than spinning on the clock
+*/
+void sleepUntil (long long When)
+{
+    long long Now = currentMillis();
+    while (When > Now)
+    {
+#ifdef _WIN32
+        Sleep((DWORD) (When - Now));
+#else
+        struct timespec ts;
+        ts.tv_sec = (When - Now) / 1000;
+        ts.tv_nsec = ((When - Now) % 1000) * 1000000;
+        // an interrupted sleep simply goes around again
+        if ((nanosleep(&ts, NULL) != 0) && (errno != EINTR))
+            break;
+#endif
+        Now = currentMillis();
+    }
+}
+
+/*
+ initDelayQueue() allocates a delay queue with every slot empty and its
+ clock set to Now
+*/
+DelayQueue initDelayQueue (long long Now)
+{
+    DelayQueue DQ = (DelayQueue) malloc(sizeof(DelayQueueInfo));
+    assert (DQ != NULL);
+    AllocationCount++;
+    for (int level = 0; level < WHEELLEVELS; level++)
+    {
+        for (int slot = 0; slot < WHEELSLOTS; slot++)
+            DQ->Slots[level][slot] = NULL;
+        DQ->Occupied[level] = 0;
+    }
+    DQ->Overflow = NULL;
+    DQ->Current = Now;
+    DQ->Count = 0;
+    return DQ;
+}
+
+/*
+ deleteDelayQueue() frees every node still waiting and then the queue
+ itself.  It returns NULL to indicate that there is no longer a queue.
+*/
+DelayQueue deleteDelayQueue (DelayQueue DQ)
+{
+    assert (DQ != NULL);
+    for (int level = 0; level <= WHEELLEVELS; level++)
+        for (int slot = 0; slot < WHEELSLOTS; slot++)
+        {
+            DelayHandle *Head = (level == WHEELLEVELS) ? &DQ->Overflow : &DQ->Slots[level][slot];
+            while (*Head != NULL)
+            {
+                DelayHandle H = *Head;
+                *Head = H->next;
+                free (H);
+                AllocationCount--;
+            }
+        }
+    free (DQ);
+    AllocationCount--;
+    return NULL;
+}
+
+/*
+ emptyDelayQueue() returns true if no data is waiting in the queue
+*/
+bool emptyDelayQueue (DelayQueue DQ)
+{
+    assert (DQ != NULL);
+    return DQ->Count == 0;
+}
+
+/*
+ enqueueDelayed() allocates a node for the UserData and links it into the
+ slot for its deadline.  A deadline already behind the wheel's clock is
+ due the next time dequeueDue() is called.
+*/
+DelayHandle enqueueDelayed (DelayQueue DQ, UserData D, long long Deadline)
+{
+    assert (DQ != NULL);
+    DelayHandle H = (DelayHandle) malloc(sizeof(DelayNode));
+    assert (H != NULL);
+    AllocationCount++;
+    H->Data = D;
+    H->Deadline = Deadline;
+    Place (DQ, H);
+    DQ->Count++;
+    return H;
+}
+
+/*
+ cancelDelayed() unlinks a node that is still waiting, frees it and
+ returns its UserData.  The handle may not be used once its data has been
+ handed back by dequeueDue() or waitDue().
+*/
+UserData cancelDelayed (DelayQueue DQ, DelayHandle H)
+{
+    assert ((DQ != NULL) && (H != NULL));
+    UserData D = H->Data;
+    Unlink (DQ, H);
+    free (H);
+    AllocationCount--;
+    DQ->Count--;
+    return D;
+}
+
+/*
+ nextDeadline() returns the time of the earliest occupied level 0 slot.
+ If level 0 is empty it returns the start of the earliest occupied slot
+ above it, which is when that slot's nodes will be placed again; a caller
+ waiting for data may find nothing due then and simply waits again.
+*/
+long long nextDeadline (DelayQueue DQ)
+{
+    assert (DQ != NULL);
+    if (DQ->Count == 0)
+        return -1;
+    if (DQ->Occupied[0] != 0)
+        return (DQ->Current & ~(long long) SLOTMASK) | LowestBit(DQ->Occupied[0]);
+    long long Start;
+    int Level;
+    NextBlock (DQ, &Start, &Level);
+    return Start;
+}
+
+/*
+ dequeueDue() moves the wheel's clock forward to Now.  Each level 0 slot
+ the clock passes is handed back onto Due.  Rather than stepping one
+ millisecond at a time, the clock jumps straight to the start of the next
+ occupied higher level slot, whose nodes are then placed again, so the
+ cost depends on the number of occupied slots and not on the time passed.
+*/
+int dequeueDue (DelayQueue DQ, long long Now, Queue Due)
+{
+    assert ((DQ != NULL) && (Due != NULL));
+    int count = 0;
+    if (Now < DQ->Current)
+        return 0;
+    for (;;)
+    {
+        // hand back the level 0 slots from the clock up to Now or the end
+        // of the clock's level 0 block, whichever comes first
+        long long BlockEnd = DQ->Current | SLOTMASK;
+        long long Limit = (Now < BlockEnd) ? Now : BlockEnd;
+        int First = (int) (DQ->Current & SLOTMASK);
+        int Last = (int) (Limit & SLOTMASK);
+        unsigned long long Range = (~0ULL << First);
+        if (Last < SLOTMASK)
+            Range &= (1ULL << (Last + 1)) - 1;
+        unsigned long long Due0 = DQ->Occupied[0] & Range;
+        while (Due0 != 0)
+        {
+            int Slot = LowestBit(Due0);
+            count += ExpireSlot (DQ, Slot, Due);
+            Due0 &= Due0 - 1;
+        }
+        if (Now <= BlockEnd)
+        {
+            DQ->Current = Now;
+            break;
+        }
+        // level 0 is now empty, so the next thing that can happen is the
+        // clock reaching the earliest occupied slot above level 0
+        long long Start;
+        int Level;
+        if (!NextBlock (DQ, &Start, &Level) || (Start > Now))
+        {
+            DQ->Current = Now;
+            break;
+        }
+        DQ->Current = Start;
+        Cascade (DQ, Level, (int) ((Start >> (WHEELBITS * Level)) & SLOTMASK));
+    }
+    return count;
+}
+
+/*
+ waitDue() sleeps until the next deadline and hands back whatever has
+ become due, going around again if that was only a higher level slot
+ being placed again
+*/
+int waitDue (DelayQueue DQ, Queue Due)
+{
+    assert (DQ != NULL);
+    int count = 0;
+    while ((count == 0) && (DQ->Count != 0))
+    {
+        sleepUntil (nextDeadline (DQ));
+        count = dequeueDue (DQ, currentMillis(), Due);
+    }
+    return count;
+}
+
+// Place finds the highest digit in which the node's deadline differs from
+// the wheel's clock and links the node at the head of that level's slot.
+// Deadlines already passed are treated as due at the clock's time.
+void Place (DelayQueue DQ, DelayHandle H)
+{
+    long long When = (H->Deadline < DQ->Current) ? DQ->Current : H->Deadline;
+    unsigned long long Differ = (unsigned long long) (When ^ DQ->Current);
+    int Level = (Differ == 0) ? 0 : HighestBit(Differ) / WHEELBITS;
+    DelayHandle *Head;
+    if (Level >= WHEELLEVELS)
+    {
+        H->Level = WHEELLEVELS;
+        H->Slot = 0;
+        Head = &DQ->Overflow;
+    }
+    else
+    {
+        H->Level = Level;
+        H->Slot = (int) ((When >> (WHEELBITS * Level)) & SLOTMASK);
+        Head = &DQ->Slots[Level][H->Slot];
+        DQ->Occupied[Level] |= 1ULL << H->Slot;
+    }
+    H->prev = NULL;
+    H->next = *Head;
+    if (*Head != NULL)
+        (*Head)->prev = H;
+    *Head = H;
+}
+
+// Unlink takes a node out of its slot's list, clearing the slot's
+// occupied bit if the list becomes empty
+void Unlink (DelayQueue DQ, DelayHandle H)
+{
+    DelayHandle *Head = (H->Level == WHEELLEVELS) ? &DQ->Overflow : &DQ->Slots[H->Level][H->Slot];
+    if (H->prev != NULL)
+        H->prev->next = H->next;
+    else
+        *Head = H->next;
+    if (H->next != NULL)
+        H->next->prev = H->prev;
+    if ((*Head == NULL) && (H->Level != WHEELLEVELS))
+        DQ->Occupied[H->Level] &= ~(1ULL << H->Slot);
+}
+
+// NextBlock looks for the lowest level above 0 with an occupied slot
+// and returns the time that slot starts.  A lower level is always due
+// before a higher one, since every slot at a level lies inside the
+// clock's current slot of the level above.  The overflow list is due
+// when the clock reaches the start of the next top level turn.
+// It returns false if nothing is waiting above level 0.
+bool NextBlock (DelayQueue DQ, long long *Start, int *Level)
+{
+    for (int level = 1; level < WHEELLEVELS; level++)
+        if (DQ->Occupied[level] != 0)
+        {
+            int Shift = WHEELBITS * (level + 1);
+            *Start = ((DQ->Current >> Shift) << Shift) |
+                     ((long long) LowestBit(DQ->Occupied[level]) << (WHEELBITS * level));
+            *Level = level;
+            return true;
+        }
+    if (DQ->Overflow != NULL)
+    {
+        int Shift = WHEELBITS * WHEELLEVELS;
+        *Start = ((DQ->Current >> Shift) + 1) << Shift;
+        *Level = WHEELLEVELS;
+        return true;
+    }
+    return false;
+}
+
+// Cascade empties one slot (or the overflow list) and places each of its
+// nodes again against the clock, which has just reached the slot's start.
+// Place links at the head of a slot, so the list is walked from its tail
+// (its oldest node) to keep the nodes in the same order in their new slots
+void Cascade (DelayQueue DQ, int Level, int Slot)
+{
+    DelayHandle List;
+    if (Level == WHEELLEVELS)
+    {
+        List = DQ->Overflow;
+        DQ->Overflow = NULL;
+    }
+    else
+    {
+        List = DQ->Slots[Level][Slot];
+        DQ->Slots[Level][Slot] = NULL;
+        DQ->Occupied[Level] &= ~(1ULL << Slot);
+    }
+    while ((List != NULL) && (List->next != NULL))
+        List = List->next;
+    while (List != NULL)
+    {
+        DelayHandle H = List;
+        List = List->prev;
+        Place (DQ, H);
+    }
+}
+
+// ExpireSlot hands back every node in a level 0 slot onto Due.  Nodes are
+// linked at the head of a slot, so the list is walked from its tail to
+// hand them back in the order they reached the slot.  Nodes with the same
+// deadline always share a slot: the clock cannot move past the start of
+// an occupied slot without cascading it, so a node enqueued later with the
+// same deadline is placed in the slot the earlier one is in at the time.
+// As Cascade keeps the order of a slot, nodes with the same deadline are
+// handed back in the order they were enqueued.
+int ExpireSlot (DelayQueue DQ, int Slot, Queue Due)
+{
+    int count = 0;
+    DelayHandle H = DQ->Slots[0][Slot];
+    while ((H != NULL) && (H->next != NULL))
+        H = H->next;
+    while (H != NULL)
+    {
+        DelayHandle Prev = H->prev;
+        enqueue (Due, H->Data);
+        free (H);
+        AllocationCount--;
+        DQ->Count--;
+        count++;
+        H = Prev;
+    }
+    DQ->Slots[0][Slot] = NULL;
+    DQ->Occupied[0] &= ~(1ULL << Slot);
+    return count;
+}
+
+// LowestBit returns the number of trailing zero bits in a bitmap
+int LowestBit (unsigned long long Bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(Bits);
+#else
+    int bit = 0;
+    while ((Bits & (1ULL << bit)) == 0)
+        bit++;
+    return bit;
+#endif
+}
+
+// HighestBit returns the index of the most significant set bit in a bitmap
+int HighestBit (unsigned long long Bits)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(Bits);
+#else
+    int bit = 63;
+    while ((Bits & (1ULL << bit)) == 0)
+        bit--;
+    return bit;
+#endif
+}
@@ -0,0 +1,82 @@
+#ifndef DELAYQUEUE_H_INCLUDED
+#define DELAYQUEUE_H_INCLUDED
+//
+//  DelayQueue.h - a queue of UserData keyed by deadline
+//
+//  Data placed in a DelayQueue stays there until its deadline has passed.
+//  The queue is a hierarchical timer wheel: WHEELLEVELS wheels of
+//  WHEELSLOTS slots each, where a slot of level k covers WHEELSLOTS^k
+//  milliseconds.  Data is dropped into the slot covering its deadline, so
+//  enqueue and cancel are O(1), and is moved down a level only when the
+//  wheel's clock reaches that slot.
+//
+
+// The calls on a DelayQueue need to pass or return UserData
+#include "UserData.h"
+// Data that has become due is handed back through a Queue
+#include "Queue.h"
+// emptyDelayQueue() returns a boolean
+#include <stdbool.h>
+
+// WHEELBITS is the number of deadline bits each level of the wheel covers.
+// With 4 levels of 64 slots, the wheel spans 2^24 milliseconds (about
+// 4.6 hours); later deadlines wait in an overflow list until the wheel
+// turns far enough to hold them.
+#define WHEELBITS 6
+#define WHEELSLOTS (1 << WHEELBITS)
+#define WHEELLEVELS 4
+
+// A DelayNode holds one piece of UserData and its deadline, and is linked
+// into the list for its wheel slot.  Level and Slot record which list
+// that is, with Level WHEELLEVELS meaning the overflow list.
+typedef struct delayNode
+{
+    UserData Data;
+    long long Deadline;
+    int Level;
+    int Slot;
+    struct delayNode *next;
+    struct delayNode *prev;
+} DelayNode, *DelayHandle;
+
+// This is the layout of a delay queue.  Slots holds the list of nodes in
+// each slot of each wheel level and Occupied has a bit set for every slot
+// whose list is not empty.  Current is the wheel's clock, the time (in
+// milliseconds) up to which due data has already been handed back.
+typedef struct {
+    DelayHandle Slots[WHEELLEVELS][WHEELSLOTS];
+    unsigned long long Occupied[WHEELLEVELS];
+    DelayHandle Overflow;
+    long long Current;
+    int Count;
+} DelayQueueInfo, *DelayQueue;
+
+
+// currentMillis() returns a monotonic clock reading in milliseconds
+long long   currentMillis (void);
+// sleepUntil() blocks the caller until currentMillis() reaches When
+void        sleepUntil (long long When);
+
+// initDelayQueue() allocates a delay queue whose clock starts at Now
+DelayQueue  initDelayQueue (long long Now);
+// emptyDelayQueue() returns true if no data is waiting for its deadline
+bool        emptyDelayQueue (DelayQueue DQ);
+// enqueueDelayed() places the UserData in the queue until Deadline in O(1)
+// and returns a handle that can be used to cancel it
+DelayHandle enqueueDelayed (DelayQueue DQ, UserData D, long long Deadline);
+// cancelDelayed() removes data that has not yet become due in O(1)
+UserData    cancelDelayed (DelayQueue DQ, DelayHandle H);
+// nextDeadline() returns the earliest time any data can become due,
+// or -1 if the queue is empty
+long long   nextDeadline (DelayQueue DQ);
+// dequeueDue() enqueues all data whose deadline is at or before Now onto
+// the queue Due, in deadline order, and returns how many there were
+int         dequeueDue (DelayQueue DQ, long long Now, Queue Due);
+// waitDue() sleeps until at least one piece of data is due and then
+// dequeues it (and any other due data) onto Due.  It returns 0 at once
+// if the delay queue is empty.
+int         waitDue (DelayQueue DQ, Queue Due);
+// deleteDelayQueue() frees all waiting data and the queue itself
+DelayQueue  deleteDelayQueue (DelayQueue DQ);
+
+#endif // DELAYQUEUE_H_INCLUDED
@@ -0,0 +1,244 @@
+//
+//  Deque.c - a double-ended queue over a map of fixed-size chunks
+//
+//  Item i of the deque lives at position Front + i counted from the start
+//  of the first chunk in the map, so it is found with one division.  Chunks
+//  are allocated as the items grow into them and freed as the items leave
+//  them.  When the items reach either end of the map, the chunk pointers are
+//  moved back to the middle of the map (doubling it first if more than half
+//  of it is in use), which never moves the items themselves.
+//
+
+// stdlib provides malloc and free
+#include <stdlib.h>
+// stdbool defines bool
+#include <stdbool.h>
+// asserts are used for checking that the deque exists and is not empty
+#include <assert.h>
+// calls the deque supports are included for consistency checking
+#include "Deque.h"
+// AllocationCount is declared with the linked list code
+#include "LinkedList.h"
+
+// INITIALMAPSIZE is the number of chunk pointers allocated by initDeque
+#define INITIALMAPSIZE 8
+
+// local function Slot returns the address of the item at Index
+static UserData *Slot      (Deque DE, int Index);
+// local function Recenter moves the chunk pointers to the middle of the
+// map, doubling the map if it is more than half full
+static void      Recenter  (Deque DE);
+// local function NeedChunk allocates the chunk holding position Position
+// if it is not already allocated
+static void      NeedChunk (Deque DE, int Position);
+// local function FreeChunk frees the chunk holding position Position
+static void      FreeChunk (Deque DE, int Position);
+
+/*
+ initDeque() allocates the deque structure and its map.  No chunks are
+ allocated until the first push, which starts in the middle of the map
+ so the deque can grow either way.
+*/
+Deque initDeque (void)
+{
+    Deque DE = (Deque) malloc(sizeof(DequeInfo));
+    assert (DE != NULL);
+    AllocationCount++;
+    DE->Map = (UserData **) malloc(INITIALMAPSIZE * sizeof(UserData *));
+    assert (DE->Map != NULL);
+    AllocationCount++;
+    for (int chunk = 0; chunk < INITIALMAPSIZE; chunk++)
+        DE->Map[chunk] = NULL;
+    DE->MapSize = INITIALMAPSIZE;
+    DE->Front = INITIALMAPSIZE / 2 * DEQUECHUNKSIZE;
+    DE->Count = 0;
+    return DE;
+}
+
+/*
+ deleteDeque() frees every allocated chunk, the map and the deque.  It
+ returns NULL to indicate that there is no longer a deque.
+*/
+Deque deleteDeque (Deque DE)
+{
+    assert (DE != NULL);
+    for (int chunk = 0; chunk < DE->MapSize; chunk++)
+        if (DE->Map[chunk] != NULL)
+        {
+            free (DE->Map[chunk]);
+            AllocationCount--;
+        }
+    free (DE->Map);
+    free (DE);
+    AllocationCount -= 2;
+    return NULL;
+}
+
+/*
+ emptyDeque() returns true if the deque holds no data
+*/
+bool emptyDeque (Deque DE)
+{
+    assert (DE != NULL);
+    return DE->Count == 0;
+}
+
+/*
+ dequeLength() returns the number of items in the deque
+*/
+int dequeLength (Deque DE)
+{
+    assert (DE != NULL);
+    return DE->Count;
+}
+
+/*
+ pushFront() steps Front back one position, making room in the map and
+ allocating a chunk if needed, and stores the UserData there
+*/
+void pushFront (Deque DE, UserData D)
+{
+    assert (DE != NULL);
+    if (DE->Front == 0)
+        Recenter (DE);
+    DE->Front--;
+    NeedChunk (DE, DE->Front);
+    DE->Count++;
+    *Slot (DE, 0) = D;
+}
+
+/*
+ pushBack() stores the UserData at the position after the last item,
+ making room in the map and allocating a chunk if needed
+*/
+void pushBack (Deque DE, UserData D)
+{
+    assert (DE != NULL);
+    if (DE->Front + DE->Count == DE->MapSize * DEQUECHUNKSIZE)
+        Recenter (DE);
+    NeedChunk (DE, DE->Front + DE->Count);
+    DE->Count++;
+    *Slot (DE, DE->Count - 1) = D;
+}
+
+/*
+ popFront() returns the first item and steps Front forward, freeing the
+ chunk the item was in if no items are left in it
+*/
+UserData popFront (Deque DE)
+{
+    assert ((DE != NULL) && (DE->Count > 0));
+    UserData D = *Slot (DE, 0);
+    DE->Front++;
+    DE->Count--;
+    if ((DE->Count == 0) || (DE->Front % DEQUECHUNKSIZE == 0))
+        FreeChunk (DE, DE->Front - 1);
+    return D;
+}
+
+/*
+ popBack() returns the last item, freeing the chunk the item was in if
+ no items are left in it
+*/
+UserData popBack (Deque DE)
+{
+    assert ((DE != NULL) && (DE->Count > 0));
+    UserData D = *Slot (DE, DE->Count - 1);
+    DE->Count--;
+    int Position = DE->Front + DE->Count;
+    if ((DE->Count == 0) || (Position % DEQUECHUNKSIZE == 0))
+        FreeChunk (DE, Position);
+    return D;
+}
+
+/*
+ peekFront() returns the first item, leaving it in the deque
+*/
+UserData peekFront (Deque DE)
+{
+    assert ((DE != NULL) && (DE->Count > 0));
+    return *Slot (DE, 0);
+}
+
+/*
+ peekBack() returns the last item, leaving it in the deque
+*/
+UserData peekBack (Deque DE)
+{
+    assert ((DE != NULL) && (DE->Count > 0));
+    return *Slot (DE, DE->Count - 1);
+}
+
+/*
+ dequeAt() returns the item at Index in O(1)
+*/
+UserData dequeAt (Deque DE, int Index)
+{
+    assert ((DE != NULL) && (Index >= 0) && (Index < DE->Count));
+    return *Slot (DE, Index);
+}
+
+/*
+ dequeSetAt() replaces the item at Index in O(1)
+*/
+void dequeSetAt (Deque DE, int Index, UserData D)
+{
+    assert ((DE != NULL) && (Index >= 0) && (Index < DE->Count));
+    *Slot (DE, Index) = D;
+}
+
+// Slot finds the chunk and the offset in the chunk of item Index
+UserData *Slot (Deque DE, int Index)
+{
+    int Position = DE->Front + Index;
+    return &DE->Map[Position / DEQUECHUNKSIZE][Position % DEQUECHUNKSIZE];
+}
+
+// Recenter is called when the items have reached an end of the map.  If
+// the chunks in use take up no more than half of the map they are moved
+// to its middle; otherwise a map twice the size is allocated and they are
+// moved to the middle of that.  Only chunk pointers are copied, and Front
+// moves by the same number of chunks so every item keeps its index.
+void Recenter (Deque DE)
+{
+    // an empty deque has no chunk in use
+    int FirstChunk = DE->Front / DEQUECHUNKSIZE;
+    int InUse = (DE->Count == 0) ? 0 : (DE->Front + DE->Count - 1) / DEQUECHUNKSIZE - FirstChunk + 1;
+    int NewSize = DE->MapSize;
+    // leave at least one free chunk at each end
+    while (InUse + 2 > NewSize / 2)
+        NewSize *= 2;
+    UserData **NewMap = (UserData **) malloc(NewSize * sizeof(UserData *));
+    assert (NewMap != NULL);
+    for (int chunk = 0; chunk < NewSize; chunk++)
+        NewMap[chunk] = NULL;
+    int NewFirst = (NewSize - InUse) / 2;
+    for (int chunk = 0; chunk < InUse; chunk++)
+        NewMap[NewFirst + chunk] = DE->Map[FirstChunk + chunk];
+    // the new map replaces the old one, so AllocationCount is unchanged
+    free (DE->Map);
+    DE->Map = NewMap;
+    DE->MapSize = NewSize;
+    DE->Front = NewFirst * DEQUECHUNKSIZE + DE->Front % DEQUECHUNKSIZE;
+}
+
+// NeedChunk allocates the chunk for a position an item is about to use
+void NeedChunk (Deque DE, int Position)
+{
+    int chunk = Position / DEQUECHUNKSIZE;
+    if (DE->Map[chunk] == NULL)
+    {
+        DE->Map[chunk] = (UserData *) malloc(DEQUECHUNKSIZE * sizeof(UserData));
+        assert (DE->Map[chunk] != NULL);
+        AllocationCount++;
+    }
+}
+
+// FreeChunk frees the chunk for a position that no item uses any longer
+void FreeChunk (Deque DE, int Position)
+{
+    int chunk = Position / DEQUECHUNKSIZE;
+    free (DE->Map[chunk]);
+    DE->Map[chunk] = NULL;
+    AllocationCount--;
+}
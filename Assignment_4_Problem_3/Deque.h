@@ -0,0 +1,57 @@
+#ifndef DEQUE_H_INCLUDED
+#define DEQUE_H_INCLUDED
+//
+//  Deque.h - a double-ended queue
+//
+//  A deque can push and pop at both its front and its back, the way a
+//  stack does at one end and a queue does across both.  It keeps its
+//  UserData in fixed-size chunks rather than one node per item, so there is
+//  no allocation per push, and any item can be read by its index in O(1).
+//
+
+// The calls on a Deque need to pass or return UserData
+#include "UserData.h"
+// emptyDeque() returns a boolean
+#include <stdbool.h>
+
+// DEQUECHUNKSIZE is the number of UserData held by each chunk
+#define DEQUECHUNKSIZE 64
+
+// This is the layout of a deque.  Map is an array of MapSize pointers to
+// chunks, with NULL for chunks not currently allocated.  The items are laid
+// out across the chunks one after another, starting Front items from the
+// start of the first chunk in Map, and there are Count of them.
+typedef struct {
+    UserData **Map;
+    int MapSize;
+    int Front;
+    int Count;
+} DequeInfo, *Deque;
+
+
+// initDeque() allocates an empty deque
+Deque       initDeque (void);
+// emptyDeque() returns true if the deque holds no data
+bool        emptyDeque (Deque DE);
+// dequeLength() returns the number of UserData in the deque
+int         dequeLength (Deque DE);
+// pushFront() places the UserData before the first item in the deque
+void        pushFront (Deque DE, UserData D);
+// pushBack() places the UserData after the last item in the deque
+void        pushBack (Deque DE, UserData D);
+// popFront() returns and removes the first item in the deque
+UserData    popFront (Deque DE);
+// popBack() returns and removes the last item in the deque
+UserData    popBack (Deque DE);
+// peekFront() returns the first item without removing it
+UserData    peekFront (Deque DE);
+// peekBack() returns the last item without removing it
+UserData    peekBack (Deque DE);
+// dequeAt() returns the item at Index, counting from 0 at the front
+UserData    dequeAt (Deque DE, int Index);
+// dequeSetAt() replaces the item at Index, counting from 0 at the front
+void        dequeSetAt (Deque DE, int Index, UserData D);
+// deleteDeque() frees all the chunks and the deque itself
+Deque       deleteDeque (Deque DE);
+
+#endif // DEQUE_H_INCLUDED
@@ -0,0 +1,402 @@
+//
+//  EventSim.c - a discrete-event simulation engine on a calendar queue
+//
+//  The calendar queue follows R. Brown's design.  An event at time t is in
+//  "year" t / Width and is kept in bucket (year mod NumBuckets), in time
+//  order.  The next event is found by stepping through the buckets from the
+//  current year, taking a bucket's first event if it belongs to the year
+//  being looked at.  Years are whole numbers worked out once per event, so
+//  rounding can never make the search skip an event.  If a whole pass over
+//  the buckets finds nothing, the earliest bucket head is taken directly.
+//
+//  The number of buckets doubles when there are more than two events per
+//  bucket and halves when there are fewer than one per two buckets.  The
+//  new width is three times the average gap between the next few events,
+//  so that most buckets hold about one event of the current year.
+//
+
+// stdlib provides malloc, realloc and free
+#include <stdlib.h>
+// stdbool defines bool
+#include <stdbool.h>
+// asserts are used for checking that the simulation exists
+#include <assert.h>
+// math provides log() for exponential random numbers (link with -lm)
+#include <math.h>
+// calls the simulation supports are included for consistency checking
+#include "EventSim.h"
+// AllocationCount is declared with the linked list code
+#include "LinkedList.h"
+
+// MINBUCKETS is the fewest buckets the calendar shrinks to
+#define MINBUCKETS 2
+// SAMPLESIZE is how many upcoming events are looked at to pick a width
+#define SAMPLESIZE 25
+// EVENTBLOCK is how many event nodes are allocated at a time
+#define EVENTBLOCK 1024
+
+// local function CalendarInsert places an event in its bucket in time order
+static void        CalendarInsert (CalendarQueue *C, SimEventPtr E);
+// local function CalendarPop removes and returns the earliest event
+static SimEventPtr CalendarPop    (CalendarQueue *C);
+// local function CalendarResize rebuilds the calendar with NumBuckets
+// buckets and a width suited to the upcoming events
+static void        CalendarResize (CalendarQueue *C, int NumBuckets);
+// local function Earlier returns true if event A comes before event B
+static bool        Earlier        (SimEventPtr A, SimEventPtr B);
+// local function NewEvent takes an event node from the free list,
+// allocating another block of nodes if the list is empty
+static SimEventPtr NewEvent       (EventSim Sim);
+
+/*
+ initEventSim() allocates the simulation and an empty calendar with
+ MINBUCKETS buckets one time unit wide
+*/
+EventSim initEventSim (unsigned long long Seed)
+{
+    EventSim Sim = (EventSim) malloc(sizeof(EventSimInfo));
+    assert (Sim != NULL);
+    AllocationCount++;
+    CalendarQueue *C = &Sim->Calendar;
+    C->Buckets = (SimEventPtr *) malloc(MINBUCKETS * sizeof(SimEventPtr));
+    assert (C->Buckets != NULL);
+    AllocationCount++;
+    for (int bucket = 0; bucket < MINBUCKETS; bucket++)
+        C->Buckets[bucket] = NULL;
+    C->NumBuckets = MINBUCKETS;
+    C->Width = 1.0;
+    C->Size = 0;
+    C->CurrentYear = 0;
+    C->LastTime = 0.0;
+    C->Resizing = false;
+    Sim->Now = 0.0;
+    Sim->NextSeq = 0;
+    Sim->Processed = 0;
+    Sim->Stopped = false;
+    Sim->Free = NULL;
+    Sim->Blocks = NULL;
+    Sim->NumBlocks = 0;
+    Sim->Rng = Seed;
+    return Sim;
+}
+
+/*
+ deleteEventSim() frees the blocks of event nodes (which include any
+ events still pending), the calendar and the simulation.  It returns NULL
+ to indicate that there is no longer a simulation.
+*/
+EventSim deleteEventSim (EventSim Sim)
+{
+    assert (Sim != NULL);
+    for (int block = 0; block < Sim->NumBlocks; block++)
+        free (Sim->Blocks[block]);
+    AllocationCount -= Sim->NumBlocks;
+    if (Sim->Blocks != NULL)
+    {
+        free (Sim->Blocks);
+        AllocationCount--;
+    }
+    free (Sim->Calendar.Buckets);
+    free (Sim);
+    AllocationCount -= 2;
+    return NULL;
+}
+
+/*
+ simNow() returns the simulated clock
+*/
+double simNow (EventSim Sim)
+{
+    assert (Sim != NULL);
+    return Sim->Now;
+}
+
+/*
+ scheduleEvent() schedules an event Delay time units from now
+*/
+void scheduleEvent (EventSim Sim, double Delay, EventHandler *Handler, UserData D)
+{
+    assert (Delay >= 0.0);
+    scheduleAt (Sim, Sim->Now + Delay, Handler, D);
+}
+
+/*
+ scheduleAt() fills in an event node and places it in the calendar
+*/
+void scheduleAt (EventSim Sim, double Time, EventHandler *Handler, UserData D)
+{
+    assert ((Sim != NULL) && (Handler != NULL) && (Time >= Sim->Now));
+    SimEventPtr E = NewEvent (Sim);
+    E->Time = Time;
+    E->Seq = Sim->NextSeq++;
+    E->Handler = Handler;
+    E->Data = D;
+    CalendarInsert (&Sim->Calendar, E);
+}
+
+/*
+ pendingEvents() returns how many events are in the calendar
+*/
+int pendingEvents (EventSim Sim)
+{
+    assert (Sim != NULL);
+    return Sim->Calendar.Size;
+}
+
+/*
+ runNextEvent() takes the earliest event, moves the clock to it, returns
+ the node to the free list and then calls the handler, so the handler's
+ own scheduling can reuse the node
+*/
+bool runNextEvent (EventSim Sim)
+{
+    assert (Sim != NULL);
+    SimEventPtr E = CalendarPop (&Sim->Calendar);
+    if (E == NULL)
+        return false;
+    Sim->Now = E->Time;
+    EventHandler *Handler = E->Handler;
+    UserData D = E->Data;
+    E->next = Sim->Free;
+    Sim->Free = E;
+    Sim->Processed++;
+    Handler (Sim, D);
+    return true;
+}
+
+/*
+ runSimulation() handles events in time order up to Until.  An event
+ taken from the calendar that turns out to be later than Until is put
+ back, and the calendar's search is moved back to Until so that events
+ scheduled from then on are found.
+*/
+long long runSimulation (EventSim Sim, double Until)
+{
+    assert (Sim != NULL);
+    long long Start = Sim->Processed;
+    CalendarQueue *C = &Sim->Calendar;
+    Sim->Stopped = false;
+    while (!Sim->Stopped)
+    {
+        SimEventPtr E = CalendarPop (C);
+        if (E == NULL)
+        {
+            if (Until > Sim->Now)
+                Sim->Now = Until;
+            break;
+        }
+        if (E->Time > Until)
+        {
+            Sim->Now = (Until > Sim->Now) ? Until : Sim->Now;
+            C->LastTime = Sim->Now;
+            C->CurrentYear = (long long) (Sim->Now / C->Width);
+            CalendarInsert (C, E);
+            break;
+        }
+        Sim->Now = E->Time;
+        EventHandler *Handler = E->Handler;
+        UserData D = E->Data;
+        E->next = Sim->Free;
+        Sim->Free = E;
+        Sim->Processed++;
+        Handler (Sim, D);
+    }
+    return Sim->Processed - Start;
+}
+
+/*
+ stopSimulation() is called by a handler to end runSimulation() early
+*/
+void stopSimulation (EventSim Sim)
+{
+    assert (Sim != NULL);
+    Sim->Stopped = true;
+}
+
+/*
+ simRandom() is the splitmix64 generator: a counter stepped by a large odd
+ constant and then scrambled.  It is fast, has a period of 2^64 and gives
+ the same numbers on every platform, unlike rand().
+*/
+unsigned long long simRandom (EventSim Sim)
+{
+    unsigned long long z = (Sim->Rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ simUniform() uses the top 53 random bits as the fraction of a double
+*/
+double simUniform (EventSim Sim)
+{
+    return (simRandom (Sim) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ simRandomInt() scales a uniform random number to 0..n-1
+*/
+int simRandomInt (EventSim Sim, int n)
+{
+    assert (n > 0);
+    return (int) (simUniform (Sim) * n);
+}
+
+/*
+ simExponential() inverts the exponential distribution's cumulative
+ probability at a uniform random number
+*/
+double simExponential (EventSim Sim, double Mean)
+{
+    return -Mean * log (1.0 - simUniform (Sim));
+}
+
+// Earlier orders events by time, and events at the same time by the order
+// they were scheduled in
+bool Earlier (SimEventPtr A, SimEventPtr B)
+{
+    return (A->Time < B->Time) || ((A->Time == B->Time) && (A->Seq < B->Seq));
+}
+
+// CalendarInsert works out the event's year, walks its bucket to the first
+// later event and links it in there, growing the calendar if it now holds
+// more than two events per bucket
+void CalendarInsert (CalendarQueue *C, SimEventPtr E)
+{
+    E->Year = (long long) (E->Time / C->Width);
+    SimEventPtr *Link = &C->Buckets[E->Year & (C->NumBuckets - 1)];
+    while ((*Link != NULL) && Earlier (*Link, E))
+        Link = &(*Link)->next;
+    E->next = *Link;
+    *Link = E;
+    C->Size++;
+    if (!C->Resizing && (C->Size > 2 * C->NumBuckets))
+        CalendarResize (C, 2 * C->NumBuckets);
+}
+
+// CalendarPop steps through the buckets a year at a time from the current
+// year, taking the first event found that belongs to the year being looked
+// at.  After a full pass with nothing found, the earliest of the bucket
+// heads is taken instead.  The calendar shrinks if it is now less than
+// half full.
+SimEventPtr CalendarPop (CalendarQueue *C)
+{
+    if (C->Size == 0)
+        return NULL;
+    SimEventPtr *Link = NULL;
+    long long Year = C->CurrentYear;
+    for (int step = 0; step < C->NumBuckets; step++, Year++)
+    {
+        SimEventPtr *Bucket = &C->Buckets[Year & (C->NumBuckets - 1)];
+        if ((*Bucket != NULL) && ((*Bucket)->Year <= Year))
+        {
+            Link = Bucket;
+            break;
+        }
+    }
+    if (Link == NULL)
+    {
+        // no event within a year of the current one, so search directly
+        for (int bucket = 0; bucket < C->NumBuckets; bucket++)
+            if ((C->Buckets[bucket] != NULL) && ((Link == NULL) || Earlier (C->Buckets[bucket], *Link)))
+                Link = &C->Buckets[bucket];
+    }
+    SimEventPtr E = *Link;
+    *Link = E->next;
+    C->CurrentYear = E->Year;
+    C->LastTime = E->Time;
+    C->Size--;
+    if (!C->Resizing && (C->NumBuckets > MINBUCKETS) && (C->Size < C->NumBuckets / 2))
+        CalendarResize (C, C->NumBuckets / 2);
+    return E;
+}
+
+// CalendarResize takes the next SAMPLESIZE events out of the calendar to
+// measure the gaps between them, ignoring gaps over twice the average,
+// and uses three times the average remaining gap as the new width.  The
+// bucket array is then replaced and every event (including the sampled
+// ones) is placed again.
+void CalendarResize (CalendarQueue *C, int NumBuckets)
+{
+    C->Resizing = true;
+    double LastTime = C->LastTime;
+    SimEventPtr Sample[SAMPLESIZE];
+    int NumSample = (C->Size < SAMPLESIZE) ? C->Size : SAMPLESIZE;
+    for (int loop = 0; loop < NumSample; loop++)
+        Sample[loop] = CalendarPop (C);
+    double Width = C->Width;
+    if (NumSample > 1)
+    {
+        double Average = (Sample[NumSample - 1]->Time - Sample[0]->Time) / (NumSample - 1);
+        double Total = 0.0;
+        int Count = 0;
+        for (int loop = 1; loop < NumSample; loop++)
+        {
+            double Gap = Sample[loop]->Time - Sample[loop - 1]->Time;
+            if (Gap <= 2.0 * Average)
+            {
+                Total += Gap;
+                Count++;
+            }
+        }
+        if ((Count > 0) && (Total > 0.0))
+            Width = 3.0 * Total / Count;
+    }
+    // gather every event left in the old buckets into one list
+    SimEventPtr All = NULL;
+    for (int bucket = 0; bucket < C->NumBuckets; bucket++)
+        while (C->Buckets[bucket] != NULL)
+        {
+            SimEventPtr E = C->Buckets[bucket];
+            C->Buckets[bucket] = E->next;
+            E->next = All;
+            All = E;
+        }
+    // the new bucket array replaces the old one, so AllocationCount is unchanged
+    free (C->Buckets);
+    C->Buckets = (SimEventPtr *) malloc(NumBuckets * sizeof(SimEventPtr));
+    assert (C->Buckets != NULL);
+    for (int bucket = 0; bucket < NumBuckets; bucket++)
+        C->Buckets[bucket] = NULL;
+    C->NumBuckets = NumBuckets;
+    C->Width = Width;
+    C->Size = 0;
+    C->LastTime = LastTime;
+    C->CurrentYear = (long long) (LastTime / Width);
+    while (All != NULL)
+    {
+        SimEventPtr E = All;
+        All = All->next;
+        CalendarInsert (C, E);
+    }
+    for (int loop = 0; loop < NumSample; loop++)
+        CalendarInsert (C, Sample[loop]);
+    C->Resizing = false;
+}
+
+// NewEvent hands out nodes from the free list.  When it is empty, a block
+// of EVENTBLOCK nodes is allocated and threaded onto the list, so events
+// cost one allocation per block rather than one each.
+SimEventPtr NewEvent (EventSim Sim)
+{
+    if (Sim->Free == NULL)
+    {
+        SimEventPtr Block = (SimEventPtr) malloc(EVENTBLOCK * sizeof(SimEvent));
+        assert (Block != NULL);
+        AllocationCount++;
+        if (Sim->Blocks == NULL)
+            AllocationCount++;
+        Sim->Blocks = (SimEventPtr *) realloc(Sim->Blocks, (Sim->NumBlocks + 1) * sizeof(SimEventPtr));
+        assert (Sim->Blocks != NULL);
+        Sim->Blocks[Sim->NumBlocks++] = Block;
+        for (int loop = 0; loop < EVENTBLOCK; loop++)
+        {
+            Block[loop].next = Sim->Free;
+            Sim->Free = &Block[loop];
+        }
+    }
+    SimEventPtr E = Sim->Free;
+    Sim->Free = E->next;
+    return E;
+}
@@ -0,0 +1,112 @@
+#ifndef EVENTSIM_H_INCLUDED
+#define EVENTSIM_H_INCLUDED
+//
+//  EventSim.h - a discrete-event simulation engine
+//
+//  A simulation is a set of future events, each a UserData to be handed
+//  to a handler function at a simulated time.  The engine repeatedly takes
+//  the earliest event, sets its clock to the event's time and calls the
+//  handler, which may schedule further events.  No real time passes, so the
+//  run goes as fast as the handlers allow.  Events at the same time are
+//  handled in the order they were scheduled, and all random numbers come
+//  from the simulation's own generator, so a run is repeatable from its seed.
+//
+//  The future events are kept in a calendar queue: an array of buckets,
+//  each covering one Width of simulated time per "year", with the events
+//  of a bucket kept in time order.  Scheduling and taking the next event
+//  are O(1) on average, and the number of buckets and their width are
+//  adjusted as the number of events changes.
+//
+//  simExponential() uses log() from math.h, so link with the math library
+//  (-lm).
+//
+
+// Events carry UserData
+#include "UserData.h"
+// runNextEvent() returns a boolean
+#include <stdbool.h>
+
+// The simulation is declared here so a handler can be given it
+typedef struct eventSimInfo *EventSim;
+
+// EventHandler is any function that, when called with the simulation and
+// an event's UserData, carries out what happens at the event's time
+typedef void EventHandler (EventSim Sim, UserData D);
+
+// A SimEvent is one future event.  Seq is the order it was scheduled in
+// and Year is its time divided by the calendar's bucket width, which picks
+// its bucket and decides which year of the calendar it belongs to.
+typedef struct simEvent
+{
+    double Time;
+    unsigned long long Seq;
+    long long Year;
+    EventHandler *Handler;
+    UserData Data;
+    struct simEvent *next;
+} SimEvent, *SimEventPtr;
+
+// This is the layout of a calendar queue.  Buckets holds NumBuckets time
+// ordered lists of events.  CurrentYear is the bucket width multiple the
+// last event taken was in, where the search for the next event starts.
+typedef struct {
+    SimEventPtr *Buckets;
+    int NumBuckets;
+    double Width;
+    int Size;
+    long long CurrentYear;
+    double LastTime;
+    bool Resizing;
+} CalendarQueue;
+
+// This is the layout of a simulation.  Now is the simulated clock, Free is
+// a list of event nodes ready for reuse and Blocks the blocks of event
+// nodes allocated so far.  Rng is the state of the random number generator.
+typedef struct eventSimInfo {
+    CalendarQueue Calendar;
+    double Now;
+    unsigned long long NextSeq;
+    long long Processed;
+    bool Stopped;
+    SimEventPtr Free;
+    SimEventPtr *Blocks;
+    int NumBlocks;
+    unsigned long long Rng;
+} EventSimInfo;
+
+
+// initEventSim() allocates a simulation with its clock at 0 and its random
+// number generator started from Seed
+EventSim    initEventSim (unsigned long long Seed);
+// simNow() returns the simulated time
+double      simNow (EventSim Sim);
+// scheduleEvent() arranges for Handler to be called with D after Delay
+// units of simulated time
+void        scheduleEvent (EventSim Sim, double Delay, EventHandler *Handler, UserData D);
+// scheduleAt() arranges for Handler to be called with D at simulated time
+// Time, which may not be earlier than simNow()
+void        scheduleAt (EventSim Sim, double Time, EventHandler *Handler, UserData D);
+// pendingEvents() returns the number of events still to happen
+int         pendingEvents (EventSim Sim);
+// runNextEvent() handles the earliest event, returning false if there
+// was none
+bool        runNextEvent (EventSim Sim);
+// runSimulation() handles events until none is left, the next one is
+// later than Until or a handler calls stopSimulation().  It returns the
+// number of events handled and leaves the clock at Until if it got there.
+long long   runSimulation (EventSim Sim, double Until);
+// stopSimulation() makes runSimulation() return after the current event
+void        stopSimulation (EventSim Sim);
+// simRandom() returns the next 64 random bits from the generator
+unsigned long long simRandom (EventSim Sim);
+// simUniform() returns a random number from 0 up to (not including) 1
+double      simUniform (EventSim Sim);
+// simRandomInt() returns a random integer from 0 to n-1
+int         simRandomInt (EventSim Sim, int n);
+// simExponential() returns an exponentially distributed random number
+// with the given mean, as used for times between random arrivals
+double      simExponential (EventSim Sim, double Mean);
+// deleteEventSim() frees all events and the simulation itself
+EventSim    deleteEventSim (EventSim Sim);
+
+#endif // EVENTSIM_H_INCLUDED
@@ -0,0 +1,175 @@
+// EventSimDemo models the arrivals and service that PriorityQueueDemo
+// acts out with real sleeps, but on the simulated clock of EventSim, so a
+// run covering days of traffic takes seconds:
+//      - NUMSOURCES independent sources each send items at random
+//        (exponentially distributed) intervals, each item with a random
+//        priority from 1 to MAXPRIO
+//      - NUMSERVERS servers each take one item at a time and spend an
+//        exponentially distributed time serving it
+//      - items that arrive while every server is busy wait in a bucket
+//        priority queue, lowest priority number first
+//
+// The arrival rate keeps the servers about UTILIZATION busy.  All random
+// numbers come from the simulation seeded with SEED, so every run gives
+// the same results.
+//
+// It prints, per priority, how many items were served and their mean and
+// worst wait, then how many events were handled and how many per second
+// of real time.
+//
+// Build it from EventSimDemo.c, EventSim.c, Queue.c and DoubleLinkedList.c
+// only (PriorityQueueDemo.c and MLFQSimulation.c have main()s of their
+// own).  EventSim uses log() from the math library and Queue uses POSIX
+// threads, so link with -lm and -pthread:
+//      gcc EventSimDemo.c EventSim.c Queue.c DoubleLinkedList.c -pthread -lm
+
+#include <stdio.h>
+// we will use malloc(), realloc() and free() from stdlib.h
+#include <stdlib.h>
+// we use assert() to check that memory was allocated
+#include <assert.h>
+// we use clock() from time.h to time the run
+#include <time.h>
+// we use the simulation engine from EventSim.h
+#include "EventSim.h"
+// the waiting line is a bucket Queue
+#include "Queue.h"
+// we use UserData to carry an item's id and priority through the events
+#include "UserData.h"
+
+#define NUMSOURCES 10000
+#define NUMSERVERS 4
+#define MAXPRIO 4
+#define SEED 20181
+#define MEANSERVICE 1.0
+#define UTILIZATION 0.9
+#define SIMTIME 1000000.0
+// the item table starts with INITIALITEMS entries and doubles as needed
+#define INITIALITEMS 1024
+
+// this local function is the handler for an item arriving from a source
+static void          Arrival (EventSim Sim, UserData D);
+// this local function is the handler for a server finishing an item
+static void          Departure (EventSim Sim, UserData D);
+// this local function starts a server on an item, recording its wait
+static void          StartService (EventSim Sim, UserData D);
+// this local function is given to the bucket queue to pick an item's level
+static int           PriorityNumIsLevel (UserData D);
+
+extern int AllocationCount;
+
+// Waiting holds the items no server is free for, IdleServers counts the
+// free servers and Arrived holds the arrival time of every item by id
+static Queue Waiting;
+static int IdleServers;
+static double *Arrived;
+static int NumItems;
+static int ItemCapacity;
+// statistics gathered for each priority as items start service
+static long long Served[MAXPRIO + 1];
+static double TotalWait[MAXPRIO + 1];
+static double MaxWait[MAXPRIO + 1];
+
+// Arrival gives the new item the next id and a random priority, starts a
+// server on it or puts it in the waiting line, and schedules the source's
+// next item.  D.id is the number of the source.
+void Arrival (EventSim Sim, UserData D)
+{
+    if (NumItems == ItemCapacity)
+    {
+        // the new table replaces the old one, so AllocationCount is unchanged
+        ItemCapacity *= 2;
+        double *Grown = (double *) realloc(Arrived, ItemCapacity * sizeof(double));
+        assert (Grown != NULL);
+        Arrived = Grown;
+    }
+    UserData Item;
+    Item.id = NumItems++;
+    Item.priority = 1 + simRandomInt(Sim, MAXPRIO);
+    Item.time[0] = 0;
+    Arrived[Item.id] = simNow(Sim);
+    if (IdleServers > 0)
+    {
+        IdleServers--;
+        StartService (Sim, Item);
+    }
+    else
+        enqueue (Waiting, Item);
+    double MeanInterarrival = NUMSOURCES * MEANSERVICE / (NUMSERVERS * UTILIZATION);
+    scheduleEvent (Sim, simExponential(Sim, MeanInterarrival), Arrival, D);
+}
+
+// Departure frees the server, which goes straight on to the highest
+// priority waiting item if there is one
+void Departure (EventSim Sim, UserData D)
+{
+    (void) D;
+    if (empty(Waiting))
+        IdleServers++;
+    else
+        StartService (Sim, dequeue(Waiting));
+}
+
+// StartService records how long the item waited and schedules the end
+// of its service
+void StartService (EventSim Sim, UserData D)
+{
+    double Wait = simNow(Sim) - Arrived[D.id];
+    Served[D.priority]++;
+    TotalWait[D.priority] += Wait;
+    if (Wait > MaxWait[D.priority])
+        MaxWait[D.priority] = Wait;
+    scheduleEvent (Sim, simExponential(Sim, MEANSERVICE), Departure, D);
+}
+
+// PriorityNumIsLevel puts priority 1 in level 0, which is dequeued first
+int PriorityNumIsLevel (UserData D)
+{
+    return D.priority - 1;
+}
+
+// main starts every source at a random time within its first interval,
+// runs the simulation for SIMTIME and prints the statistics
+int main()
+{
+    EventSim Sim = initEventSim(SEED);
+    Waiting = initBucketQueue(PriorityNumIsLevel, MAXPRIO);
+    IdleServers = NUMSERVERS;
+    ItemCapacity = INITIALITEMS;
+    NumItems = 0;
+    Arrived = (double *) malloc(ItemCapacity * sizeof(double));
+    assert (Arrived != NULL);
+    AllocationCount++;
+    double MeanInterarrival = NUMSOURCES * MEANSERVICE / (NUMSERVERS * UTILIZATION);
+    for (int source = 0; source < NUMSOURCES; source++)
+    {
+        UserData D;
+        D.id = source;
+        D.priority = 0;
+        D.time[0] = 0;
+        scheduleEvent (Sim, simExponential(Sim, MeanInterarrival), Arrival, D);
+    }
+    printf ("Total allocations is %d after scheduling %d sources\n", AllocationCount, NUMSOURCES);
+
+    clock_t Start = clock();
+    long long Events = runSimulation(Sim, SIMTIME);
+    double Seconds = (double) (clock() - Start) / CLOCKS_PER_SEC;
+
+    printf ("\n%d sources, %d servers, simulated time %.0f, %d items arrived\n",
+            NUMSOURCES, NUMSERVERS, simNow(Sim), NumItems);
+    printf ("priority     served   meanWait    maxWait\n");
+    for (int priority = 1; priority <= MAXPRIO; priority++)
+        printf ("%8d %10lld %10.3f %10.3f\n", priority, Served[priority],
+                Served[priority] ? TotalWait[priority] / Served[priority] : 0.0, MaxWait[priority]);
+    printf ("\n%lld events handled in %.2f seconds", Events, Seconds);
+    if (Seconds > 0.0)
+        printf (" (%.0f events per second)", Events / Seconds);
+    printf ("\n%d events left pending\n", pendingEvents(Sim));
+
+    free (Arrived);
+    AllocationCount--;
+    Waiting = deleteQueue(Waiting);
+    Sim = deleteEventSim(Sim);
+    printf ("\nAllocation count after the simulation is %d\n", AllocationCount);
+    return 0;
+}
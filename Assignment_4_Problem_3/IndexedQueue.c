@@ -0,0 +1,258 @@
+//
+//  IndexedQueue.c - an addressable priority queue
+//
+//  The queue is a binary heap of handles kept in an array.  Every handle
+//  remembers where it sits in the heap, so data that is already waiting can
+//  be found in O(1) and sifted up or down to a new place in O(log n).
+//
+
+// stdlib provides malloc, realloc and free
+#include <stdlib.h>
+// stdbool defines bool
+#include <stdbool.h>
+// asserts are used for checking that the queue and handles exist
+#include <assert.h>
+// calls the queue supports are included for consistency checking
+#include "IndexedQueue.h"
+// AllocationCount is declared with the linked list code
+#include "LinkedList.h"
+
+// INITIALCAPACITY is the number of handles allocated by initIndexedQueue.
+// The arrays double in size whenever they fill up.
+#define INITIALCAPACITY 16
+
+// local function Higher returns true if handle A should leave the queue
+// before handle B
+static bool Higher   (IndexedQueue IQ, QueueHandle A, QueueHandle B);
+// local function Place stores a handle at a heap index and records the
+// index in the handle's entry
+static void Place    (IndexedQueue IQ, QueueHandle H, int Index);
+// local function SiftUp moves the handle at Index toward the top of the heap
+static void SiftUp   (IndexedQueue IQ, int Index);
+// local function SiftDown moves the handle at Index toward the bottom of the heap
+static void SiftDown (IndexedQueue IQ, int Index);
+// local function Grow doubles the number of handles the queue can hold
+static void Grow     (IndexedQueue IQ);
+
+/*
+ initIndexedQueue() allocates the queue structure and its heap, entry and
+ free handle arrays.  Unlike initQueue(), a comparison is required since
+ the queue is always ordered by priority.
+*/
+IndexedQueue initIndexedQueue (UserComparison UserOrder)
+{
+    assert (UserOrder != NULL);
+    // allocate a queue structure and abort if the allocation failed
+    IndexedQueue IQ = (IndexedQueue) malloc(sizeof(IndexedQueueInfo));
+    assert (IQ != NULL);
+    AllocationCount++;
+    // allocate the heap, entry and free handle arrays
+    IQ->Heap = (QueueHandle *) malloc(INITIALCAPACITY * sizeof(QueueHandle));
+    IQ->Entries = (IndexedEntry *) malloc(INITIALCAPACITY * sizeof(IndexedEntry));
+    IQ->FreeHandles = (QueueHandle *) malloc(INITIALCAPACITY * sizeof(QueueHandle));
+    assert ((IQ->Heap != NULL) && (IQ->Entries != NULL) && (IQ->FreeHandles != NULL));
+    AllocationCount += 3;
+    IQ->Capacity = INITIALCAPACITY;
+    // nothing is queued and no handle has been given out yet
+    IQ->Size = 0;
+    IQ->NumFree = 0;
+    IQ->NumHandles = 0;
+    IQ->NextOrder = 0;
+    // save the user's comparison function pointer
+    IQ->Priority = UserOrder;
+    return IQ;
+}
+
+/*
+ deleteIndexedQueue() frees the arrays and the queue structure itself.  It
+ returns NULL to indicate that there is no longer a queue.
+*/
+IndexedQueue deleteIndexedQueue (IndexedQueue IQ)
+{
+    assert (IQ != NULL);
+    free (IQ->Heap);
+    free (IQ->Entries);
+    free (IQ->FreeHandles);
+    free (IQ);
+    AllocationCount -= 4;
+    return NULL;
+}
+
+/*
+ emptyIndexed() returns true if no data is waiting in the queue
+*/
+bool emptyIndexed (IndexedQueue IQ)
+{
+    assert (IQ != NULL);
+    return IQ->Size == 0;
+}
+
+/*
+ enqueueIndexed() takes a free handle (or a new one), fills in its entry,
+ adds it at the bottom of the heap and sifts it up to its place.  The
+ handle is returned so the caller can find the data again.
+*/
+QueueHandle enqueueIndexed (IndexedQueue IQ, UserData D)
+{
+    assert (IQ != NULL);
+    QueueHandle H;
+    if (IQ->NumFree > 0)
+        H = IQ->FreeHandles[--IQ->NumFree];
+    else
+    {
+        if (IQ->NumHandles == IQ->Capacity)
+            Grow (IQ);
+        H = IQ->NumHandles++;
+    }
+    IQ->Entries[H].Data = D;
+    IQ->Entries[H].Order = IQ->NextOrder++;
+    Place (IQ, H, IQ->Size++);
+    SiftUp (IQ, IQ->Entries[H].HeapIndex);
+    return H;
+}
+
+/*
+ dequeueIndexed() removes the handle at the top of the heap and returns
+ its data
+*/
+UserData dequeueIndexed (IndexedQueue IQ)
+{
+    assert ((IQ != NULL) && (IQ->Size > 0));
+    return removeItem (IQ, IQ->Heap[0]);
+}
+
+/*
+ peekIndexed() returns the data at the top of the heap, leaving it queued
+*/
+UserData peekIndexed (IndexedQueue IQ)
+{
+    assert ((IQ != NULL) && (IQ->Size > 0));
+    return IQ->Entries[IQ->Heap[0]].Data;
+}
+
+/*
+ isQueued() returns true if the handle has been given out and its data
+ has not yet left the queue
+*/
+bool isQueued (IndexedQueue IQ, QueueHandle H)
+{
+    assert (IQ != NULL);
+    return (H >= 0) && (H < IQ->NumHandles) && (IQ->Entries[H].HeapIndex >= 0);
+}
+
+/*
+ getItem() returns the data named by a queued handle
+*/
+UserData getItem (IndexedQueue IQ, QueueHandle H)
+{
+    assert (isQueued (IQ, H));
+    return IQ->Entries[H].Data;
+}
+
+/*
+ changePriority() replaces the data named by a queued handle.  The data
+ keeps its original enqueue order for ties, and since it may now be of
+ higher or lower priority it is sifted both up and down (only one of the
+ two will move it).
+*/
+void changePriority (IndexedQueue IQ, QueueHandle H, UserData D)
+{
+    assert (isQueued (IQ, H));
+    IQ->Entries[H].Data = D;
+    SiftUp (IQ, IQ->Entries[H].HeapIndex);
+    SiftDown (IQ, IQ->Entries[H].HeapIndex);
+}
+
+/*
+ removeItem() takes a queued handle out of the heap by moving the last
+ heap handle into its place and sifting that handle to where it belongs.
+ The removed handle goes on the free stack and its data is returned.
+*/
+UserData removeItem (IndexedQueue IQ, QueueHandle H)
+{
+    assert (isQueued (IQ, H));
+    int Index = IQ->Entries[H].HeapIndex;
+    UserData D = IQ->Entries[H].Data;
+    // move the last handle in the heap into the hole
+    QueueHandle Last = IQ->Heap[--IQ->Size];
+    if (Last != H)
+    {
+        Place (IQ, Last, Index);
+        SiftUp (IQ, Index);
+        SiftDown (IQ, IQ->Entries[Last].HeapIndex);
+    }
+    // the handle is no longer in use and can be given out again
+    IQ->Entries[H].HeapIndex = -1;
+    IQ->FreeHandles[IQ->NumFree++] = H;
+    return D;
+}
+
+// Higher uses the user's comparison to decide which handle leaves the
+// queue first.  The comparison may return true for equal priorities, so
+// A is only strictly higher if the comparison does not also say B is
+// higher than A.  Equal priorities leave in the order they were enqueued.
+bool Higher (IndexedQueue IQ, QueueHandle A, QueueHandle B)
+{
+    UserData a = IQ->Entries[A].Data;
+    UserData b = IQ->Entries[B].Data;
+    bool AFirst = IQ->Priority(a, b);
+    bool BFirst = IQ->Priority(b, a);
+    if (AFirst != BFirst)
+        return AFirst;
+    return IQ->Entries[A].Order < IQ->Entries[B].Order;
+}
+
+// Place puts handle H at heap position Index and remembers the position
+void Place (IndexedQueue IQ, QueueHandle H, int Index)
+{
+    IQ->Heap[Index] = H;
+    IQ->Entries[H].HeapIndex = Index;
+}
+
+// SiftUp swaps the handle at Index with its parent for as long as it is
+// of higher priority than the parent
+void SiftUp (IndexedQueue IQ, int Index)
+{
+    QueueHandle H = IQ->Heap[Index];
+    while (Index > 0)
+    {
+        int Parent = (Index - 1) / 2;
+        if (!Higher (IQ, H, IQ->Heap[Parent]))
+            break;
+        Place (IQ, IQ->Heap[Parent], Index);
+        Index = Parent;
+    }
+    Place (IQ, H, Index);
+}
+
+// SiftDown swaps the handle at Index with its higher priority child for as
+// long as that child is of higher priority than the handle
+void SiftDown (IndexedQueue IQ, int Index)
+{
+    QueueHandle H = IQ->Heap[Index];
+    for (;;)
+    {
+        int Child = 2 * Index + 1;
+        if (Child >= IQ->Size)
+            break;
+        if ((Child + 1 < IQ->Size) && Higher (IQ, IQ->Heap[Child + 1], IQ->Heap[Child]))
+            Child++;
+        if (!Higher (IQ, IQ->Heap[Child], H))
+            break;
+        Place (IQ, IQ->Heap[Child], Index);
+        Index = Child;
+    }
+    Place (IQ, H, Index);
+}
+
+// Grow doubles the capacity of the heap, entry and free handle arrays.
+// realloc keeps the same number of allocations, so AllocationCount is
+// unchanged.
+void Grow (IndexedQueue IQ)
+{
+    IQ->Capacity *= 2;
+    IQ->Heap = (QueueHandle *) realloc(IQ->Heap, IQ->Capacity * sizeof(QueueHandle));
+    IQ->Entries = (IndexedEntry *) realloc(IQ->Entries, IQ->Capacity * sizeof(IndexedEntry));
+    IQ->FreeHandles = (QueueHandle *) realloc(IQ->FreeHandles, IQ->Capacity * sizeof(QueueHandle));
+    assert ((IQ->Heap != NULL) && (IQ->Entries != NULL) && (IQ->FreeHandles != NULL));
+}
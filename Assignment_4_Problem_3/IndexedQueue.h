@@ -0,0 +1,74 @@
+#ifndef INDEXEDQUEUE_H_INCLUDED
+#define INDEXEDQUEUE_H_INCLUDED
+//
+//  IndexedQueue.h - an addressable priority queue
+//
+//  Unlike Queue.h, every enqueue returns a handle that stays valid while
+//  the data is waiting in the queue.  The handle can be used to change the
+//  priority of the waiting data or to remove it, without draining and
+//  rebuilding the queue.
+//
+
+// The calls on an IndexedQueue need to pass or return UserData
+#include "UserData.h"
+// The priority comparison is the same UserComparison used by Queue.h
+#include "Queue.h"
+// emptyIndexed() and isQueued() return a boolean
+#include <stdbool.h>
+
+// A QueueHandle identifies one piece of UserData in an IndexedQueue.
+// Handles are reused once their data leaves the queue, so a handle must
+// not be used after the data it names has been dequeued or removed.
+typedef int QueueHandle;
+
+// Each handle names one IndexedEntry.  It holds the user's data, the
+// order it was enqueued in (so that data of equal priority leaves the
+// queue oldest first) and where the handle currently sits in the heap
+// (-1 when the handle is not in use).
+typedef struct {
+    UserData Data;
+    unsigned long Order;
+    int HeapIndex;
+} IndexedEntry;
+
+// This is the layout of an indexed priority queue.  Heap is a binary heap
+// of handles ordered by the user's comparison, Entries is indexed by handle
+// and FreeHandles is a stack of handles that can be given out again.
+typedef struct {
+    QueueHandle *Heap;
+    IndexedEntry *Entries;
+    QueueHandle *FreeHandles;
+    int Size;
+    int NumFree;
+    int NumHandles;
+    int Capacity;
+    unsigned long NextOrder;
+    UserComparison *Priority;
+} IndexedQueueInfo, *IndexedQueue;
+
+
+// initIndexedQueue() allocates an indexed priority queue that orders its
+// data with the user's comparison
+IndexedQueue initIndexedQueue (UserComparison UserOrder);
+// emptyIndexed() returns true if the queue holds no data
+bool         emptyIndexed (IndexedQueue IQ);
+// enqueueIndexed() places the UserData in the queue in O(log n) and
+// returns the handle that names it
+QueueHandle  enqueueIndexed (IndexedQueue IQ, UserData D);
+// dequeueIndexed() returns and removes the highest priority UserData
+UserData     dequeueIndexed (IndexedQueue IQ);
+// peekIndexed() returns the highest priority UserData without removing it
+UserData     peekIndexed (IndexedQueue IQ);
+// isQueued() returns true if the handle names data waiting in the queue
+bool         isQueued (IndexedQueue IQ, QueueHandle H);
+// getItem() returns the UserData named by a handle
+UserData     getItem (IndexedQueue IQ, QueueHandle H);
+// changePriority() replaces the UserData named by a handle and moves it
+// to its new place in the queue in O(log n)
+void         changePriority (IndexedQueue IQ, QueueHandle H, UserData D);
+// removeItem() removes and returns the UserData named by a handle in O(log n)
+UserData     removeItem (IndexedQueue IQ, QueueHandle H);
+// deleteIndexedQueue() frees the storage allocated by initIndexedQueue()
+IndexedQueue deleteIndexedQueue (IndexedQueue IQ);
+
+#endif // INDEXEDQUEUE_H_INCLUDED
@@ -0,0 +1,171 @@
+//
+//  MLFQ.c - a multi-level feedback queue scheduler built on Queue.c
+//
+//  Each level is a Queue created without a priority comparison, so work
+//  enters and leaves a level in O(1).  A bitmap of occupied levels finds
+//  the highest level holding work without looking at the empty ones.
+//
+
+// stdlib provides malloc and free
+#include <stdlib.h>
+// stdbool defines bool
+#include <stdbool.h>
+// asserts are used for checking that the scheduler exists
+#include <assert.h>
+// limits.h provides INT_MAX, the largest slice a level can have
+#include <limits.h>
+// calls the scheduler supports are included for consistency checking
+#include "MLFQ.h"
+// AllocationCount is declared with the linked list code
+#include "LinkedList.h"
+
+// local function HighestLevel returns the lowest numbered level holding work
+static int HighestLevel (MLFQ S);
+
+/*
+ initMLFQ() allocates the scheduler, a Queue for each level and the
+ table of time slices, doubling the slice at each level down.  Once a
+ slice would no longer fit in an int, the lower levels all get INT_MAX
+*/
+MLFQ initMLFQ (int NumLevels, int BaseSlice, long long BoostInterval)
+{
+    assert ((NumLevels > 0) && (NumLevels <= MAXMLFQLEVELS) && (BaseSlice > 0));
+    MLFQ S = (MLFQ) malloc(sizeof(MLFQInfo));
+    assert (S != NULL);
+    S->Levels = (Queue *) malloc(NumLevels * sizeof(Queue));
+    S->Slices = (int *) malloc(NumLevels * sizeof(int));
+    assert ((S->Levels != NULL) && (S->Slices != NULL));
+    AllocationCount += 3;
+    for (int level = 0; level < NumLevels; level++)
+    {
+        S->Levels[level] = initQueue(NULL);
+        if (level == 0)
+            S->Slices[level] = BaseSlice;
+        else if (S->Slices[level - 1] > INT_MAX / 2)
+            S->Slices[level] = INT_MAX;
+        else
+            S->Slices[level] = 2 * S->Slices[level - 1];
+    }
+    S->NumLevels = NumLevels;
+    S->Occupied = 0;
+    S->Count = 0;
+    S->BoostInterval = BoostInterval;
+    S->LastBoost = 0;
+    return S;
+}
+
+/*
+ deleteMLFQ() deletes each level's Queue, the tables and the scheduler.
+ It returns NULL to indicate that there is no longer a scheduler.
+*/
+MLFQ deleteMLFQ (MLFQ S)
+{
+    assert (S != NULL);
+    for (int level = 0; level < S->NumLevels; level++)
+        S->Levels[level] = deleteQueue(S->Levels[level]);
+    free (S->Levels);
+    free (S->Slices);
+    free (S);
+    AllocationCount -= 3;
+    return NULL;
+}
+
+/*
+ emptyMLFQ() returns true if no level holds work
+*/
+bool emptyMLFQ (MLFQ S)
+{
+    assert (S != NULL);
+    return S->Count == 0;
+}
+
+/*
+ admitTask() starts new work at the top level
+*/
+void admitTask (MLFQ S, UserData D)
+{
+    enqueueAtLevel (S, D, 0);
+}
+
+/*
+ enqueueAtLevel() adds work at the end of a level and marks the level
+ as occupied
+*/
+void enqueueAtLevel (MLFQ S, UserData D, int Level)
+{
+    assert ((S != NULL) && (Level >= 0) && (Level < S->NumLevels));
+    enqueue (S->Levels[Level], D);
+    S->Occupied |= 1ULL << Level;
+    S->Count++;
+}
+
+/*
+ pickNext() dequeues from the highest occupied level, clearing the level's
+ occupied bit if that empties it
+*/
+UserData pickNext (MLFQ S, int *Level)
+{
+    assert ((S != NULL) && (S->Count > 0));
+    int level = HighestLevel (S);
+    UserData D = dequeue (S->Levels[level]);
+    if (empty (S->Levels[level]))
+        S->Occupied &= ~(1ULL << level);
+    S->Count--;
+    *Level = level;
+    return D;
+}
+
+/*
+ timeSlice() returns the number of ticks given to work picked from a level
+*/
+int timeSlice (MLFQ S, int Level)
+{
+    assert ((S != NULL) && (Level >= 0) && (Level < S->NumLevels));
+    return S->Slices[Level];
+}
+
+/*
+ demoteLevel() moves work that ran for its whole slice down one level
+ (the lowest level keeps it).  Work that gave up the processor before its
+ slice ran out stays where it was.
+*/
+int demoteLevel (MLFQ S, int Level, int Used)
+{
+    assert ((S != NULL) && (Level >= 0) && (Level < S->NumLevels));
+    if ((Used >= S->Slices[Level]) && (Level < S->NumLevels - 1))
+        return Level + 1;
+    return Level;
+}
+
+/*
+ boostIfDue() moves the work in every lower level to the end of level 0,
+ highest level first so that work keeps its relative order, once
+ BoostInterval ticks have passed since the last boost
+*/
+bool boostIfDue (MLFQ S, long long Now)
+{
+    assert (S != NULL);
+    if ((S->BoostInterval <= 0) || (Now - S->LastBoost < S->BoostInterval))
+        return false;
+    S->LastBoost = Now;
+    for (int level = 1; level < S->NumLevels; level++)
+        while (!empty (S->Levels[level]))
+            enqueue (S->Levels[0], dequeue (S->Levels[level]));
+    if (S->Count > 0)
+        S->Occupied = 1;
+    return true;
+}
+
+// HighestLevel returns the number of trailing zero bits in the
+// occupancy bitmap, which is the lowest numbered occupied level
+int HighestLevel (MLFQ S)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(S->Occupied);
+#else
+    int level = 0;
+    while ((S->Occupied & (1ULL << level)) == 0)
+        level++;
+    return level;
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef MLFQ_H_INCLUDED
+#define MLFQ_H_INCLUDED
+//
+//  MLFQ.h - a multi-level feedback queue scheduler
+//
+//  Work waits in one of several FIFO levels, level 0 being run first.
+//  New work starts at level 0.  Work that uses up the whole time slice of
+//  its level is moved down a level, where the slices are longer, so short
+//  work finishes quickly and long work still gets the processor in longer
+//  runs.  Every so often all waiting work is boosted back to level 0 so
+//  that the low levels are never starved.
+//
+
+// The calls on the scheduler need to pass or return UserData
+#include "UserData.h"
+// Each level is a simple (no priority) Queue
+#include "Queue.h"
+// emptyMLFQ() returns a boolean
+#include <stdbool.h>
+
+// MAXMLFQLEVELS is the largest number of levels the scheduler supports.
+// It matches the number of bits in the occupancy bitmap used to find the
+// highest non-empty level.
+#define MAXMLFQLEVELS 64
+
+// This is the layout of the scheduler.  Levels holds one Queue per level
+// and Slices the time slice (in ticks) given to work picked from each
+// level.  Occupied has a bit set for every level holding work.
+// BoostInterval is how many ticks pass between boosts (0 for never) and
+// LastBoost is when the last boost was done.
+typedef struct {
+    Queue *Levels;
+    int *Slices;
+    int NumLevels;
+    unsigned long long Occupied;
+    int Count;
+    long long BoostInterval;
+    long long LastBoost;
+} MLFQInfo, *MLFQ;
+
+
+// initMLFQ() allocates a scheduler with NumLevels levels.  Level 0 gets a
+// slice of BaseSlice ticks and each level below it twice the slice of
+// the level above, up to INT_MAX.
+MLFQ        initMLFQ (int NumLevels, int BaseSlice, long long BoostInterval);
+// emptyMLFQ() returns true if no work is waiting
+bool        emptyMLFQ (MLFQ S);
+// admitTask() places new work at the end of level 0
+void        admitTask (MLFQ S, UserData D);
+// enqueueAtLevel() places work at the end of the given level
+void        enqueueAtLevel (MLFQ S, UserData D, int Level);
+// pickNext() removes and returns the work at the front of the highest
+// non-empty level in O(1), setting *Level to the level it came from
+UserData    pickNext (MLFQ S, int *Level);
+// timeSlice() returns the number of ticks work from a level may run
+int         timeSlice (MLFQ S, int Level);
+// demoteLevel() returns the level work should wait at after running Used
+// ticks from Level: one level down if it used its whole slice
+int         demoteLevel (MLFQ S, int Level, int Used);
+// boostIfDue() moves all waiting work to level 0 if BoostInterval ticks
+// have passed since the last boost, returning true if it did
+bool        boostIfDue (MLFQ S, long long Now);
+// deleteMLFQ() frees the levels and the scheduler itself
+MLFQ        deleteMLFQ (MLFQ S);
+
+#endif // MLFQ_H_INCLUDED
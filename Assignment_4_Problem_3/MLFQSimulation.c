@@ -0,0 +1,213 @@
+// MLFQSimulation runs one randomly generated workload through three
+// scheduling policies built on the MLFQ scheduler, so that their throughput
+// and latency can be compared for each class of work:
+//      - ROUND ROBIN uses a single level, so every task takes turns
+//      - STATIC PRIORITY uses one level per class with no demotion or
+//        boost, like the priority queue in PriorityQueueDemo, which lets
+//        a steady stream of high priority work starve the lower classes
+//      - FEEDBACK uses several levels with demotion and periodic boosts
+//
+// Time is simulated: the clock is a count of ticks that jumps forward by
+// however long the picked task runs, so no real time passes.  The random
+// number generator is seeded with SEED so every run sees the same tasks.
+//
+// For each policy it prints, per class, how many tasks completed, the
+// throughput in tasks per 1000 ticks, and the mean, median, 99th
+// percentile and worst turnaround time (arrival to completion) as well as
+// the mean response time (arrival to first run).
+
+#include <stdio.h>
+// we will use rand(), srand(), malloc(), free() and qsort() from stdlib.h
+#include <stdlib.h>
+// we use a bool from stdbool.h
+#include <stdbool.h>
+// we use assert() to check that memory was allocated
+#include <assert.h>
+// we use the MLFQ scheduler from MLFQ.h
+#include "MLFQ.h"
+// we use UserData to carry a task's id and class through the scheduler
+#include "UserData.h"
+
+#define NUMTASKS 20000
+#define MAXPRIO 4
+#define SEED 20181
+// tasks arrive on average every MEANINTERARRIVAL ticks, which keeps the
+// processor about 90% busy for the service demands below
+#define MEANINTERARRIVAL 210
+#define BASESLICE 8
+#define FEEDBACKLEVELS 6
+#define BOOSTINTERVAL 4000
+
+// the shortest and longest service demand (in ticks) of each class,
+// class 1 being short interactive work and class MAXPRIO long batch work
+static const int MinDemand[MAXPRIO + 1] = {0, 1, 10, 50, 200};
+static const int MaxDemand[MAXPRIO + 1] = {0, 10, 50, 200, 1000};
+
+// Policy selects how the simulation uses the scheduler
+typedef enum {ROUNDROBIN, STATICPRIORITY, FEEDBACK} Policy;
+
+// Task holds everything the simulation knows about one task.  Only its
+// id (the index in the task table) and class travel through the scheduler
+typedef struct {
+    int taskClass;
+    long long arrival;
+    int demand;
+    int remaining;
+    long long firstRun;
+    long long finish;
+} Task;
+
+// this local function fills the task table with random arrivals,
+// classes and service demands
+static void      generateTasks (Task tasks[], int numTasks);
+// this local function runs the tasks to completion under one policy
+// and prints the statistics for each class
+static void      simulate (Policy P, Task tasks[], int numTasks);
+// this local function prints the statistics for one class of tasks
+static void      reportClass (Task tasks[], int numTasks, int taskClass, long long makespan);
+// this local function is given to qsort to order turnaround times
+static int       compareTicks (const void *first, const void *second);
+
+extern int AllocationCount;
+
+// generateTasks gives each task an arrival time a random number of ticks
+// (1 to 2*MEANINTERARRIVAL-1) after the previous task, a random class and a
+// random service demand within the range for its class
+void generateTasks (Task tasks[], int numTasks)
+{
+    long long clock = 0;
+    for (int loop = 0; loop < numTasks; loop++)
+    {
+        clock += 1 + rand() % (2 * MEANINTERARRIVAL - 1);
+        tasks[loop].arrival = clock;
+        tasks[loop].taskClass = 1 + rand() % MAXPRIO;
+        int low = MinDemand[tasks[loop].taskClass];
+        int high = MaxDemand[tasks[loop].taskClass];
+        tasks[loop].demand = low + rand() % (high - low + 1);
+    }
+}
+
+// simulate admits each task when the clock reaches its arrival time and
+// then repeatedly picks a task, runs it for its level's time slice (or
+// until it completes) and, if it did not complete, puts it back at the
+// level the policy chooses
+void simulate (Policy P, Task tasks[], int numTasks)
+{
+    static const char *Names[] = {"ROUND ROBIN", "STATIC PRIORITY", "FEEDBACK"};
+    int numLevels = (P == ROUNDROBIN) ? 1 : (P == STATICPRIORITY) ? MAXPRIO : FEEDBACKLEVELS;
+    MLFQ S = initMLFQ(numLevels, BASESLICE, (P == FEEDBACK) ? BOOSTINTERVAL : 0);
+    for (int loop = 0; loop < numTasks; loop++)
+    {
+        tasks[loop].remaining = tasks[loop].demand;
+        tasks[loop].firstRun = -1;
+    }
+    long long now = 0;
+    long long picks = 0;
+    int nextArrival = 0;
+    int completed = 0;
+    while (completed < numTasks)
+    {
+        // admit every task that has arrived by now
+        while ((nextArrival < numTasks) && (tasks[nextArrival].arrival <= now))
+        {
+            UserData D;
+            D.id = nextArrival;
+            D.priority = tasks[nextArrival].taskClass;
+            D.time[0] = 0;
+            if (P == STATICPRIORITY)
+                enqueueAtLevel (S, D, D.priority - 1);
+            else
+                admitTask (S, D);
+            nextArrival++;
+        }
+        // an idle processor waits for the next arrival
+        if (emptyMLFQ(S))
+        {
+            now = tasks[nextArrival].arrival;
+            continue;
+        }
+        boostIfDue (S, now);
+        int level;
+        UserData D = pickNext (S, &level);
+        picks++;
+        Task *T = &tasks[D.id];
+        if (T->firstRun < 0)
+            T->firstRun = now;
+        int run = timeSlice (S, level);
+        if (run > T->remaining)
+            run = T->remaining;
+        now += run;
+        T->remaining -= run;
+        if (T->remaining == 0)
+        {
+            T->finish = now;
+            completed++;
+        }
+        else if (P == FEEDBACK)
+            enqueueAtLevel (S, D, demoteLevel (S, level, run));
+        else
+            enqueueAtLevel (S, D, level);
+    }
+    printf ("\n%s: %d tasks finished after %lld ticks with %lld scheduling decisions\n",
+            Names[P], numTasks, now, picks);
+    printf ("class  done  per1000  meanTurn  p50Turn  p99Turn  maxTurn  meanResp\n");
+    for (int taskClass = 1; taskClass <= MAXPRIO; taskClass++)
+        reportClass (tasks, numTasks, taskClass, now);
+    S = deleteMLFQ (S);
+}
+
+// reportClass gathers the turnaround times of the tasks in one class,
+// sorts them to find the percentiles and prints one line of statistics
+void reportClass (Task tasks[], int numTasks, int taskClass, long long makespan)
+{
+    long long *turnaround = (long long *) malloc(numTasks * sizeof(long long));
+    assert (turnaround != NULL);
+    AllocationCount++;
+    int count = 0;
+    long long totalTurn = 0;
+    long long totalResp = 0;
+    for (int loop = 0; loop < numTasks; loop++)
+        if (tasks[loop].taskClass == taskClass)
+        {
+            turnaround[count] = tasks[loop].finish - tasks[loop].arrival;
+            totalTurn += turnaround[count];
+            totalResp += tasks[loop].firstRun - tasks[loop].arrival;
+            count++;
+        }
+    if (count > 0)
+    {
+        qsort (turnaround, count, sizeof(long long), compareTicks);
+        printf ("%5d %5d %8.2f %9.1f %8lld %8lld %8lld %9.1f\n", taskClass, count,
+                1000.0 * count / makespan, (double) totalTurn / count,
+                turnaround[count / 2], turnaround[(count * 99) / 100], turnaround[count - 1],
+                (double) totalResp / count);
+    }
+    free (turnaround);
+    AllocationCount--;
+}
+
+// compareTicks orders two tick counts from smallest to largest
+int compareTicks (const void *first, const void *second)
+{
+    long long a = *(const long long *) first;
+    long long b = *(const long long *) second;
+    return (a > b) - (a < b);
+}
+
+// main generates the workload once and runs it through each policy,
+// printing the allocation count to show everything was freed
+int main()
+{
+    srand (SEED);
+    Task *tasks = (Task *) malloc(NUMTASKS * sizeof(Task));
+    assert (tasks != NULL);
+    AllocationCount++;
+    generateTasks (tasks, NUMTASKS);
+    simulate (ROUNDROBIN, tasks, NUMTASKS);
+    simulate (STATICPRIORITY, tasks, NUMTASKS);
+    simulate (FEEDBACK, tasks, NUMTASKS);
+    free (tasks);
+    AllocationCount--;
+    printf ("\nAllocation count after the simulations is %d\n", AllocationCount);
+    return 0;
+}
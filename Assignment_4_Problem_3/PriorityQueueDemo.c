@@ -1,7 +1,7 @@
 // PriorityQueueTester will demonstrate the init, enqueue, peek, dequeue and delete
-// for three different types of queues (a queue without priority, a queue where the
-// lowest number is the highest priority and a queue where the highest number is
-// the highest priority.
+// for four different types of queues (a queue without priority, a queue where the
+// lowest number is the highest priority, a queue where the highest number is
+// the highest priority and a bucket queue keeping one FIFO per priority level.
 //      - It prints the type of queue being tested
 //      - It builds a queue that holds UserData generated based on user's
 //        current time across an interval
@@ -25,14 +25,50 @@
 #include <string.h>
 // we use a bool from stdbool.h
 #include <stdbool.h>
+// we use assert() to check that threads started and memory was allocated
+#include <assert.h>
 // we use Queue functions from Queue.h
 #include "Queue.h"
 // we use UserData for the queue
 #include "UserData.h"
+// we use IndexedQueue functions from IndexedQueue.h
+#include "IndexedQueue.h"
+// we use DelayQueue functions (and its clock) from DelayQueue.h
+#include "DelayQueue.h"
+// we use Deque functions from Deque.h
+#include "Deque.h"
 
 #define MAXPRIO 4
 #define DEQUEUESPERENQUEUE 3
 #define INITIALENQUEUES 15
+#define INDEXEDENQUEUES 5
+#define DELAYENQUEUES 8
+#define MAXDELAYMS 3000
+#define DEQUEITEMS 200
+#define DEQUEWINDOW 5
+#define BLOCKINGCAPACITY 8
+#define BLOCKINGITEMS 5000
+#define BLOCKINGBATCH 32
+#define BLOCKINGTIMEOUTMS 100
+
+// the blocking queue test runs producers and consumers as threads,
+// started and joined through StartThread and JoinThread.  Thread
+// functions return THREADRESULT and are given a BlockingWorker that says
+// what the thread does and collects what it saw.
+#ifdef _WIN32
+typedef HANDLE Thread;
+#define THREADRESULT DWORD WINAPI
+#else
+typedef pthread_t Thread;
+#define THREADRESULT void *
+#endif
+typedef struct {
+    BlockingQueue BQ;
+    int First;
+    int Count;
+    bool Batched;
+    long long Sum;
+} BlockingWorker;
 
 // this local function receives a queue
 // as an argument to populates, peek
@@ -44,6 +80,37 @@ static void          Runtest (Queue Q);
 // and a number of items as arguments
 // so to fill the queue with that data
 static void          buildQueue (Queue Q, int numItems);
+// this local function fills an indexed queue,
+// changes the priority of one item through its
+// handle, removes another through its handle and
+// dequeues the rest while printing messages
+static void          RunIndexedTest (IndexedQueue IQ);
+// this local function places data in a delay
+// queue with random deadlines, cancels one and
+// waits for the rest to become due, printing
+// messages along the way
+static void          RunDelayTest (DelayQueue DQ);
+// this local function slides a window across
+// a deque, pushing at the back and popping at
+// the front, then reads the window by index and
+// empties it from both ends
+static void          RunDequeTest (Deque DE);
+// this local function shows a blocking queue
+// timing out, then passes data from two
+// producer threads to two consumer threads
+// through it and closes it
+static void          RunBlockingTest (BlockingQueue BQ);
+// these local functions are the producer and
+// consumer threads of the blocking queue test
+static THREADRESULT  Producer (void *Arg);
+static THREADRESULT  Consumer (void *Arg);
+// these local functions start a thread running
+// a function and wait for a thread to finish
+static void          StartThread (Thread *T, THREADRESULT (*Run)(void *), void *Arg);
+static void          JoinThread (Thread T);
+// this local function prints the depth and
+// wait time statistics gathered by a queue
+static void          printQueueStats (Queue Q);
 // this local function creates a data
 // and assign it a random priority number
 // between 1 and MAXPRIO
@@ -64,6 +131,12 @@ static bool          LowestNumIsHighestPriority (UserData first, UserData second
 // priority numbers are listed as higher priority
 // in the queue
 static bool          HighestNumIsHighestPriority (UserData first, UserData second);
+// this local function takes one UserData
+// object and returns the level of a bucket
+// queue it belongs in, so that priority
+// number 1 is level 0 (the highest level)
+// and priority MAXPRIO is level MAXPRIO-1
+static int           PriorityNumIsLevel (UserData D);
 
 // this is an int variable that is defined elsewhere
 // in the source code. It is listed here as extern
@@ -74,15 +147,22 @@ extern int AllocationCount;
 // buildQueue takes a queue and a number
 // in order to fill the queue with
 // data and print that data along with
-// its priority number
+// its priority number.  All the data is
+// generated first and then placed in the
+// queue with a single enqueueMany call
 void buildQueue (Queue Q, int numItems)
 {
-    for (; numItems > 0; numItems--)
+    UserData *items = (UserData *) malloc(numItems * sizeof(UserData));
+    assert (items != NULL);
+    AllocationCount++;
+    for (int loop = 0; loop < numItems; loop++)
     {
-        UserData D = genTimePriorityUserData();
-        enqueue (Q, D);
-        printf ("Time = %s queued at priority %d\n", D.time, D.priority);
+        items[loop] = genTimePriorityUserData();
+        printf ("Time = %s queued at priority %d\n", items[loop].time, items[loop].priority);
     }
+    enqueueMany (Q, items, numItems);
+    free (items);
+    AllocationCount--;
     return;
 }
 
@@ -90,7 +170,7 @@ void buildQueue (Queue Q, int numItems)
 // Function: genTimePriorityUserData
 //    This function fills a UserData structure with the current
 //    system time and a random priority from 1 to MAXPRIO.
-//    Before exiting, this routine spins for 1 second so
+//    Before exiting, this routine sleeps for 1 second so
 //    that another, immediate call will have a different
 //    time stamp.  It then returns the populated UserData.
 //*****************************************************
@@ -108,16 +188,9 @@ UserData genTimePriorityUserData ()
     UserData D;
     strcpy (D.time, theTime);
     D.priority = 1 + rand() % MAXPRIO;
-    // spin for at least 1 second so that the time field will
+    // sleep for 1 second so that the time field will
     // be different if we are called again immediately
-    time_t time_now;
-    do
-    {
-        // get the current time (seconds)
-        time_now= time(NULL);
-        // spin here if it hasn't changed by at least 1 second
-    }
-    while ((time_now - current_time) == 0);
+    sleepUntil (currentMillis() + 1000);
     return D;
 }
 
@@ -147,6 +220,15 @@ bool HighestNumIsHighestPriority (UserData first, UserData second)
         return false;
 }
 
+// PriorityNumIsLevel is called by a bucket queue whenever
+// data is enqueued to pick the level that holds it.
+// Priority numbers run from 1 to MAXPRIO, so the lowest
+// number lands in level 0 and is dequeued first
+int PriorityNumIsLevel (UserData D)
+{
+    return D.priority - 1;
+}
+
 void Runtest (Queue Q)
 {
     // seed the random number generator so it doesn't always
@@ -159,34 +241,34 @@ void Runtest (Queue Q)
     buildQueue (Q, INITIALENQUEUES);
     printf ("Total allocations is %d after buildQueue\n", AllocationCount);
     printf ("Starting to dequeue and queue information\n");
-    // we will enqueue 1 item after dequeueing at most DEQUESPERENQUEUE
+    // we will enqueue 1 item after dequeueing DEQUESPERENQUEUE
     // items by priority unless the queue is exhausted.
     // if that happens, we are done
-    int NumToDequeue = DEQUEUESPERENQUEUE;
-    // peek data, print it, then dequeue it and print it
+    UserData batch[DEQUEUESPERENQUEUE];
+    // dequeue a batch of data and print it
     // until the queue no longer contains any data.
     // data is added along the way to prove the queue is
     // still functional or intact and this new data
     // gets dequeued as well.
     while (empty(Q) != true)
     {
-        UserData D = dequeue (Q);
-        printf ("  Allocation = %2d, dequeued data: ", AllocationCount);
-        printf ("Priority %-3d Time = %s\n", D.priority, D.time);
+        int NumDequeued = dequeueMany (Q, batch, DEQUEUESPERENQUEUE);
+        for (int loop = 0; loop < NumDequeued; loop++)
+        {
+            printf ("  Allocation = %2d, dequeued data: ", AllocationCount);
+            printf ("Priority %-3d Time = %s\n", batch[loop].priority, batch[loop].time);
+        }
         // if we have dequeued DEQUEUESPERENQUEUE items, generate
         // and queue another one to show that the queue is intact
         // even if we have begun dequeueing items
-        if (--NumToDequeue == 0)
+        if (NumDequeued == DEQUEUESPERENQUEUE)
         {
             // generate random data and a time stamp
             UserData D = genTimePriorityUserData();
             // place previously randomly generated
-            // data into the queue at the end of
-            // the linked list
+            // data into the queue
             enqueue (Q, D);
             printf ("Time = %s queued at priority %d\n", D.time, D.priority);
-            // reestablish how many items to dequeue before the next enqueue
-            NumToDequeue = DEQUEUESPERENQUEUE;
         }
     }
     // only the allocation of the queue itself remains to be freed
@@ -194,20 +276,259 @@ void Runtest (Queue Q)
     return;
 }
 
-// main takes no arguments and is responsible for testing three different kinds
+// RunIndexedTest enqueues INDEXEDENQUEUES items, keeping their handles.
+// It then escalates the last item to the highest priority and removes the
+// first item, both through their handles, before dequeueing the rest
+void RunIndexedTest (IndexedQueue IQ)
+{
+    QueueHandle handles[INDEXEDENQUEUES];
+    for (int loop = 0; loop < INDEXEDENQUEUES; loop++)
+    {
+        UserData D = genTimePriorityUserData();
+        handles[loop] = enqueueIndexed (IQ, D);
+        printf ("Time = %s queued at priority %d with handle %d\n", D.time, D.priority, handles[loop]);
+    }
+    // escalate the last item enqueued to the highest priority
+    UserData D = getItem (IQ, handles[INDEXEDENQUEUES-1]);
+    printf ("Changing Time = %s from priority %d to priority 1\n", D.time, D.priority);
+    D.priority = 1;
+    changePriority (IQ, handles[INDEXEDENQUEUES-1], D);
+    // remove the first item enqueued without dequeueing anything else
+    D = removeItem (IQ, handles[0]);
+    printf ("Removed Time = %s at priority %d\n", D.time, D.priority);
+    while (emptyIndexed(IQ) != true)
+    {
+        D = dequeueIndexed (IQ);
+        printf ("  Allocation = %2d, dequeued data: ", AllocationCount);
+        printf ("Priority %-3d Time = %s\n", D.priority, D.time);
+    }
+    return;
+}
+
+// RunDelayTest places DELAYENQUEUES items in the delay queue, each due
+// a random number of milliseconds (up to MAXDELAYMS) from now, and cancels
+// the first one.  It then sleeps until items become due and dequeues them,
+// printing how late each deadline was served
+void RunDelayTest (DelayQueue DQ)
+{
+    long long start = currentMillis();
+    DelayHandle first = NULL;
+    for (int loop = 0; loop < DELAYENQUEUES; loop++)
+    {
+        UserData D;
+        D.priority = 1 + rand() % MAXPRIO;
+        long long delay = rand() % MAXDELAYMS;
+        sprintf (D.time, "+%lld ms", delay);
+        DelayHandle H = enqueueDelayed (DQ, D, start + delay);
+        if (first == NULL)
+            first = H;
+        printf ("Deadline %s queued at priority %d\n", D.time, D.priority);
+    }
+    UserData D = cancelDelayed (DQ, first);
+    printf ("Cancelled deadline %s\n", D.time);
+    // due items are handed back through a simple queue
+    Queue Due = initQueue(NULL);
+    while (emptyDelayQueue(DQ) != true)
+    {
+        waitDue (DQ, Due);
+        long long now = currentMillis();
+        while (empty(Due) != true)
+        {
+            D = dequeue (Due);
+            printf ("  Allocation = %2d, due data: ", AllocationCount);
+            printf ("Priority %-3d Deadline %s served at +%lld ms\n", D.priority, D.time, now - start);
+        }
+    }
+    Due = deleteQueue (Due);
+    return;
+}
+
+// RunDequeTest pushes DEQUEITEMS items of random priority at the back of
+// the deque, keeping only the last DEQUEWINDOW of them by popping the
+// front.  The sum of the window's priorities is kept as items enter and
+// leave.  The final window is printed by index, and then emptied by
+// popping alternately from the back and the front
+void RunDequeTest (Deque DE)
+{
+    int windowSum = 0;
+    for (int loop = 0; loop < DEQUEITEMS; loop++)
+    {
+        UserData D;
+        D.priority = 1 + rand() % MAXPRIO;
+        sprintf (D.time, "item %d", loop);
+        pushBack (DE, D);
+        windowSum += D.priority;
+        if (dequeLength(DE) > DEQUEWINDOW)
+            windowSum -= popFront(DE).priority;
+    }
+    printf ("Allocation = %2d, last %d items have priority sum %d:\n", AllocationCount, DEQUEWINDOW, windowSum);
+    for (int index = 0; index < dequeLength(DE); index++)
+        printf ("  Index %d holds %s at priority %d\n", index, dequeAt(DE, index).time, dequeAt(DE, index).priority);
+    // the item just before the window goes back on the front
+    UserData D;
+    D.priority = 0;
+    sprintf (D.time, "item %d", DEQUEITEMS - DEQUEWINDOW - 1);
+    pushFront (DE, D);
+    bool fromBack = true;
+    while (emptyDeque(DE) != true)
+    {
+        D = fromBack ? popBack(DE) : popFront(DE);
+        printf ("  Allocation = %2d, popped %s from the %s\n", AllocationCount, D.time, fromBack ? "back" : "front");
+        fromBack = !fromBack;
+    }
+    return;
+}
+
+// RunBlockingTest first shows a timed dequeue giving up on the empty
+// queue.  Two producers then enqueue BLOCKINGITEMS items each, one at a
+// time and in batches of BLOCKINGBATCH, while two consumers dequeue them
+// one at a time and in batches.  The queue holds only BLOCKINGCAPACITY
+// items, so the producers keep waiting for the consumers.  Once the
+// producers finish the queue is closed, the consumers finish what is
+// left, and the counts and sums of the ids prove every item was seen once.
+void RunBlockingTest (BlockingQueue BQ)
+{
+    UserData D;
+    long long start = currentMillis();
+    BlockingStatus Status = dequeueTimed(BQ, &D, BLOCKINGTIMEOUTMS);
+    printf ("Dequeue from the empty queue %s after %lld ms\n",
+            Status == BLOCKING_TIMEDOUT ? "timed out" : "did not time out", currentMillis() - start);
+    BlockingWorker Workers[4];
+    Thread Threads[4];
+    for (int loop = 0; loop < 4; loop++)
+    {
+        Workers[loop].BQ = BQ;
+        Workers[loop].First = (loop % 2) * BLOCKINGITEMS;
+        Workers[loop].Count = 0;
+        Workers[loop].Batched = (loop % 2) == 1;
+        Workers[loop].Sum = 0;
+    }
+    // workers 0 and 1 consume, workers 2 and 3 produce
+    for (int loop = 0; loop < 4; loop++)
+        StartThread (&Threads[loop], loop < 2 ? Consumer : Producer, &Workers[loop]);
+    JoinThread (Threads[2]);
+    JoinThread (Threads[3]);
+    closeBlockingQueue (BQ);
+    JoinThread (Threads[0]);
+    JoinThread (Threads[1]);
+    long long expected = (long long) (2 * BLOCKINGITEMS) * (2 * BLOCKINGITEMS - 1) / 2;
+    printf ("Consumers took %d and %d items, sum of ids %lld (expected %lld)\n",
+            Workers[0].Count, Workers[1].Count, Workers[0].Sum + Workers[1].Sum, expected);
+    printf ("After closing, enqueue %s and dequeue %s\n",
+            enqueueBlocking(BQ, D) ? "succeeded" : "was refused",
+            dequeueTimed(BQ, &D, BLOCKINGTIMEOUTMS) == BLOCKING_CLOSED ? "reported closed" : "did not report closed");
+    return;
+}
+
+// Producer enqueues BLOCKINGITEMS items numbered from First, either one at a
+// time or in batches of BLOCKINGBATCH
+THREADRESULT Producer (void *Arg)
+{
+    BlockingWorker *W = (BlockingWorker *) Arg;
+    UserData Batch[BLOCKINGBATCH];
+    int n = 0;
+    for (int loop = 0; loop < BLOCKINGITEMS; loop++)
+    {
+        UserData D;
+        D.id = W->First + loop;
+        D.priority = 1 + D.id % MAXPRIO;
+        D.time[0] = 0;
+        if (!W->Batched)
+            enqueueBlocking (W->BQ, D);
+        else
+        {
+            Batch[n++] = D;
+            if ((n == BLOCKINGBATCH) || (loop == BLOCKINGITEMS - 1))
+            {
+                enqueueBlockingMany (W->BQ, Batch, n);
+                n = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+// Consumer dequeues, one at a time or in batches, until the queue is
+// closed and empty, counting the items and adding up their ids
+THREADRESULT Consumer (void *Arg)
+{
+    BlockingWorker *W = (BlockingWorker *) Arg;
+    UserData Batch[BLOCKINGBATCH];
+    int n;
+    do
+    {
+        n = W->Batched ? dequeueBlockingMany(W->BQ, Batch, BLOCKINGBATCH)
+                       : dequeueBlocking(W->BQ, &Batch[0]) ? 1 : 0;
+        for (int loop = 0; loop < n; loop++)
+            W->Sum += Batch[loop].id;
+        W->Count += n;
+    } while (n > 0);
+    return 0;
+}
+
+// StartThread starts a thread running Run(Arg)
+void StartThread (Thread *T, THREADRESULT (*Run)(void *), void *Arg)
+{
+#ifdef _WIN32
+    *T = CreateThread(NULL, 0, Run, Arg, 0, NULL);
+    assert (*T != NULL);
+#else
+    int Result = pthread_create(T, NULL, Run, Arg);
+    assert (Result == 0);
+    (void) Result;
+#endif
+}
+
+// JoinThread waits for a thread to finish
+void JoinThread (Thread T)
+{
+#ifdef _WIN32
+    WaitForSingleObject(T, INFINITE);
+    CloseHandle(T);
+#else
+    pthread_join(T, NULL);
+#endif
+}
+
+// printQueueStats takes a snapshot of a queue's statistics and prints
+// the largest depth and, for every priority that was dequeued, the number
+// of dequeues and the mean, median, 99th percentile and largest wait
+void printQueueStats (Queue Q)
+{
+    QueueStats S;
+    snapshotQueueStats (Q, &S);
+    printf ("Queue statistics: %lld enqueues, %lld dequeues, largest depth %d\n",
+            S.Enqueues, S.Dequeues, S.MaxDepth);
+    for (int priority = 0; priority < QUEUESTATPRIORITIES; priority++)
+        if (S.WaitCount[priority] > 0)
+            printf ("  Priority %d: %lld dequeued, wait ms mean %lld p50 %lld p99 %lld max %lld\n",
+                    priority, S.WaitCount[priority], S.WaitTotal[priority] / S.WaitCount[priority] / 1000,
+                    queueStatsPercentile (&S, priority, 50) / 1000, queueStatsPercentile (&S, priority, 99) / 1000,
+                    S.WaitMax[priority] / 1000);
+    return;
+}
+
+// main takes no arguments and is responsible for testing four different kinds
 // of queues including a queue without priority, a queue where the lowest number
-// is the highest priority and a queue where the highest number is the highest
-// priority. Each test allocates a queue and its linked list but also
+// is the highest priority, a queue where the highest number is the highest
+// priority and a bucket queue with one FIFO per priority number. Each test allocates a queue and its linked list but also
 // prints descriptions of steps taken to test the queue as well as
 // AllocationCount along the way. This includes the generation of 15
 // sequential times, each a second apart, based on user's current time.
 // That data is printed and added into the queue. Then that data is removed from
 // the queue differently based on what kind of queue is used including first in-first
 // out, first in-first out with lowest number as dequeue priority and first in-first
-// out with highest number as dequeue priority. Dequeues are printed alongside
+// out with highest number as dequeue priority, and first in-first out within
+// each bucket level with the lowest level dequeued first (for which wait
+// time statistics are gathered and printed). Dequeues are printed alongside
 // the AllocationCount. Along the way, new data is added to the queue to prove
 // the queue is still intact. This data gets removed too so that after all data has
 // been removed, the queue is deleted and the next queue is tested.
+// Finally, an indexed queue shows data being re-prioritized and removed
+// through the handles returned when it was enqueued, a delay queue
+// shows data being handed back once its deadline has passed, and a deque
+// slides a window across data by pushing and popping at both ends.
+// Last, a blocking queue passes data between producer and consumer threads.
 int main()
 {
     printf ("Demonstrating how the queue works WITHOUT a priority application\n");
@@ -232,5 +553,43 @@ int main()
     Runtest(Q);
     Q = deleteQueue (Q);
     printf ("After deleteQueue, remaining allocations is %d \n", AllocationCount);
+    printf ("\n\nDemonstrating how the queue works as a BUCKET queue\n");
+    printf ("The lowest priority number should be the highest priority to dequeue\n");
+    // provide a routine that maps priorities to MAXPRIO levels so that
+    // each level keeps its own FIFO
+    Q = initBucketQueue(PriorityNumIsLevel, MAXPRIO);
+    printf ("Total allocations is %d after initBucketQueue\n", AllocationCount);
+    // gather statistics on how long each priority waits in the queue
+    enableQueueStats(Q);
+    printf ("Total allocations is %d after enableQueueStats\n", AllocationCount);
+    Runtest(Q);
+    printQueueStats(Q);
+    Q = deleteQueue (Q);
+    printf ("After deleteQueue, remaining allocations is %d \n", AllocationCount);
+    printf ("\n\nDemonstrating how an INDEXED queue changes and removes queued data\n");
+    printf ("The lowest priority number should be the highest priority to dequeue\n");
+    IndexedQueue IQ = initIndexedQueue(LowestNumIsHighestPriority);
+    printf ("Total allocations is %d after initIndexedQueue\n", AllocationCount);
+    RunIndexedTest(IQ);
+    IQ = deleteIndexedQueue (IQ);
+    printf ("After deleteIndexedQueue, remaining allocations is %d \n", AllocationCount);
+    printf ("\n\nDemonstrating how a DELAY queue hands back data by deadline\n");
+    DelayQueue DQ = initDelayQueue(currentMillis());
+    printf ("Total allocations is %d after initDelayQueue\n", AllocationCount);
+    RunDelayTest(DQ);
+    DQ = deleteDelayQueue (DQ);
+    printf ("After deleteDelayQueue, remaining allocations is %d \n", AllocationCount);
+    printf ("\n\nDemonstrating how a DEQUE works at both ends\n");
+    Deque DE = initDeque();
+    printf ("Total allocations is %d after initDeque\n", AllocationCount);
+    RunDequeTest(DE);
+    DE = deleteDeque (DE);
+    printf ("After deleteDeque, remaining allocations is %d \n", AllocationCount);
+    printf ("\n\nDemonstrating how a BLOCKING queue passes data between threads\n");
+    BlockingQueue BQ = initBlockingQueue(BLOCKINGCAPACITY);
+    printf ("Total allocations is %d after initBlockingQueue\n", AllocationCount);
+    RunBlockingTest(BQ);
+    BQ = deleteBlockingQueue (BQ);
+    printf ("After deleteBlockingQueue, remaining allocations is %d \n", AllocationCount);
     return 0;
 }
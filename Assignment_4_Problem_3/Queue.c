@@ -2,8 +2,15 @@
 //  Queue.c with priority support
 //
 
+#ifndef _WIN32
+// clock_gettime is a POSIX call
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 // stdlib provides malloc and free
 #include <stdlib.h>
+// string provides memset for clearing statistics
+#include <string.h>
 // stdbool defines bool
 #include <stdbool.h>
 // asserts are used for checking that the queue exists
@@ -13,22 +20,76 @@
 // the queue uses a linked list to implement a queue behavior (FIFO)
 // enqueue and pop will be done from the list front.
 #include "LinkedList.h"
+#ifdef _WIN32
+// QueryPerformanceCounter times enqueues when statistics are enabled
+#include <windows.h>
+#else
+// clock_gettime times enqueues when statistics are enabled
+#include <time.h>
+#endif
+
+// local function Higher returns true if heap entry A should leave a
+// priority queue before heap entry B
+static bool Higher   (Queue Q, QueueEntry *A, QueueEntry *B);
+// local function SiftUp moves the heap entry at Index toward the top
+// of the heap until its parent is of higher priority
+static void SiftUp   (Queue Q, int Index);
+// local function SiftDown moves the heap entry at Index toward the bottom
+// of the heap until both its children are of lower priority
+static void SiftDown (Queue Q, int Index);
+// local function GrowHeap makes room in the heap for at least Needed entries
+static void GrowHeap (Queue Q, int Needed);
+// local function HighestLevel returns the number of the highest priority
+// (lowest numbered) level of a bucket queue that currently holds data
+static int  HighestLevel (Queue Q);
+// local function CurrentMicros reads a monotonic clock in microseconds
+static long long CurrentMicros (void);
+// local function RecordEnqueue counts an enqueue in the statistics and
+// returns its time, also saving the time in Ring unless Ring is NULL
+static long long RecordEnqueue (Queue Q, StampRing *Ring);
+// local function RecordDequeue counts a dequeue and the time the data
+// waited since Stamp in the statistics for its priority
+static void RecordDequeue (Queue Q, UserData D, long long Stamp);
+// local functions PushStamp and PopStamp add a time at the end of a
+// StampRing and remove the time at its front
+static void PushStamp (StampRing *Ring, long long Stamp);
+static long long PopStamp (StampRing *Ring);
+// local function HistogramBucket returns the histogram bucket for a wait
+static int  HistogramBucket (long long Wait);
+// local function BucketLimit returns the largest wait counted in a bucket
+static long long BucketLimit (int Bucket);
+// local functions LockQueue and UnlockQueue take and release a blocking
+// queue's lock
+static void LockQueue (BlockingQueue BQ);
+static void UnlockQueue (BlockingQueue BQ);
+// local function WaitSignal releases the lock and waits for Signal to be
+// given, taking the lock again before it returns.  Deadline is a time from
+// CurrentMicros to give up at (or -1 to wait forever) and it returns false
+// if the deadline passed.
+static bool WaitSignal (BlockingQueue BQ, QueueSignal *Signal, long long Deadline);
+// local functions WakeOne and WakeAll give a signal to one or to every
+// thread waiting on it
+static void WakeOne (QueueSignal *Signal);
+static void WakeAll (QueueSignal *Signal);
+// local function TakeBlocking moves up to k UserData from the front of a
+// blocking queue into out[], waking enqueuers, and returns how many it moved
+static int  TakeBlocking (BlockingQueue BQ, UserData out[], int k);
 
-// local function AdjustQueue is called whenever an enqueue is done
-// to reorder the underlying list by priority, preserving the oldest
-// enqueued order among equal priorities already in the queue
-static void AdjustQueue (Queue Q);
+// INITIALHEAPSIZE is the number of entries allocated for a priority queue's
+// heap by initQueue.  The heap doubles in size whenever it fills up.
+#define INITIALHEAPSIZE 16
 
 /*
  initQueue() allocates a queue structure and initializes its contents.
- This consists of creating the underlying linked list, declaring the
- queue to be empty, and saving the pointer to the user function used
+ This consists of creating the underlying linked list (or heap), declaring
+ the queue to be empty, and saving the pointer to the user function used
  to determine the priority in the queue
 
  IF NULL IS PASSED, THIS QUEUE WILL OPERATE AS A NORMAL QUEUE.
  IF THE USER'S PRIORITY COMPARISON FUNCTION ADDRESS IS PASSED, IT
  WILL BE CALLED TO DETERMINE WHERE IN THE QUEUE THE ENQUEUED DATA WILL
- RESIDE
+ RESIDE.  The data is then kept in a binary heap, so enqueue and dequeue
+ are O(log n) and enqueueMany can restore heap order in O(n).
 */
 Queue initQueue(UserComparison UserOrder)
 {
@@ -36,25 +97,118 @@ Queue initQueue(UserComparison UserOrder)
     Queue Q = (Queue) malloc(sizeof(QueueInfo));
     assert (Q!= NULL);
     AllocationCount++;
-    // allocate and initialize the underlying linked list
-    Q->LL = LL_Init();
+    if (UserOrder == NULL)
+    {
+        // allocate and initialize the underlying linked list
+        Q->LL = LL_Init();
+        Q->Heap = NULL;
+        Q->HeapCapacity = 0;
+    }
+    else
+    {
+        // allocate the heap that keeps the data in priority order
+        Q->LL = NULL;
+        Q->Heap = (QueueEntry *) malloc(INITIALHEAPSIZE * sizeof(QueueEntry));
+        assert (Q->Heap != NULL);
+        AllocationCount++;
+        Q->HeapCapacity = INITIALHEAPSIZE;
+    }
+    Q->HeapSize = 0;
+    Q->NextOrder = 0;
     // we are empty until an item is pushed
     Q->empty = true;
     // save the user's comparison function pointer
     Q->Priority = UserOrder;
+    // this is not a bucket queue
+    Q->Level = NULL;
+    Q->NumLevels = 0;
+    Q->Buckets = NULL;
+    Q->Occupied = 0;
+    // statistics are off until enableQueueStats is called
+    Q->Stats = NULL;
+    Q->Rings = NULL;
+    // return the queue to the caller
+    return Q;
+}
+
+/*
+ initBucketQueue() allocates a queue structure that keeps one linked list
+ (FIFO) per priority level instead of a single list kept sorted by a
+ comparison.  The user's level function is saved and called on every
+ enqueue to pick the level's list, and a bitmap of occupied levels lets
+ dequeue find the highest priority data without looking at empty levels.
+ enqueue and dequeue are therefore O(1), and data at the same level leaves
+ the queue in the order it was enqueued.
+
+ Levels run from 0 (dequeued first) to NumLevels-1, and NumLevels may not
+ exceed MAXBUCKETLEVELS.
+*/
+Queue initBucketQueue(UserPriorityLevel UserLevel, int NumLevels)
+{
+    assert (UserLevel != NULL);
+    assert ((NumLevels > 0) && (NumLevels <= MAXBUCKETLEVELS));
+    // allocate a queue structure and abort if the allocation failed
+    Queue Q = (Queue) malloc(sizeof(QueueInfo));
+    assert (Q!= NULL);
+    AllocationCount++;
+    // a bucket queue does not use the single list, a heap or a comparison
+    Q->LL = NULL;
+    Q->Heap = NULL;
+    Q->HeapSize = Q->HeapCapacity = 0;
+    Q->NextOrder = 0;
+    Q->Priority = NULL;
+    // allocate the per level lists
+    Q->Buckets = (LLInfoPtr *) malloc(NumLevels * sizeof(LLInfoPtr));
+    assert (Q->Buckets != NULL);
+    AllocationCount++;
+    for (int level = 0; level < NumLevels; level++)
+        Q->Buckets[level] = LL_Init();
+    // save the user's level function and the number of levels
+    Q->Level = UserLevel;
+    Q->NumLevels = NumLevels;
+    // we are empty until an item is pushed, so no level is occupied
+    Q->empty = true;
+    Q->Occupied = 0;
+    // statistics are off until enableQueueStats is called
+    Q->Stats = NULL;
+    Q->Rings = NULL;
     // return the queue to the caller
     return Q;
 }
 
 /*
- deleteQueue() calls the linked list delete to free up all of its nodes and, on return,
- frees up the queue itself.  it returns NULL to indicate that there is no longer a
- queue.
+ deleteQueue() calls the linked list delete to free up all of its nodes (or
+ frees the heap) and, on return, frees up the queue itself.  it returns NULL
+ to indicate that there is no longer a queue.
  */
 Queue deleteQueue(Queue Q)
 {
     assert (Q != NULL);
-    LL_Delete(Q->LL);
+    if (Q->Stats != NULL)
+    {
+        // free the enqueue times and the statistics themselves
+        int NumRings = (Q->Buckets != NULL) ? Q->NumLevels : (Q->Heap != NULL) ? 0 : 1;
+        for (int ring = 0; ring < NumRings; ring++)
+            free (Q->Rings[ring].Stamps);
+        free (Q->Rings);
+        free (Q->Stats);
+        AllocationCount -= NumRings + 2;
+    }
+    if (Q->Buckets != NULL)
+    {
+        // a bucket queue frees each level's list and then the list array
+        for (int level = 0; level < Q->NumLevels; level++)
+            LL_Delete(Q->Buckets[level]);
+        free (Q->Buckets);
+        AllocationCount--;
+    }
+    else if (Q->Heap != NULL)
+    {
+        free (Q->Heap);
+        AllocationCount--;
+    }
+    else
+        LL_Delete(Q->LL);
     free (Q);
     AllocationCount--;
     return NULL;
@@ -69,70 +223,207 @@ bool empty (Queue Q)
     return Q->empty;
 }
 
-// AdjustQueue is a bubble sort that sorts by priority
-// if the user provided a priority comparison
-// support routine. If one is not provided, the
-// function will leave the queue in the order
-// that enqueue calls have been made.  That makes it
-// operate as a simple queue.
-void AdjustQueue (Queue Q)
+// Higher uses the user's comparison to decide which heap entry leaves the
+// queue first.  The comparison may return true for equal priorities, so
+// A is only strictly higher if the comparison does not also say B is
+// higher than A.  Equal priorities leave in the order they were enqueued.
+bool Higher (Queue Q, QueueEntry *A, QueueEntry *B)
 {
-    assert (Q != NULL);
-    int Qsize = LL_Length(Q->LL);
-    // we are done if there is no priority function
-    // or there are 0 or 1 items in the queue
-    if ((Q->Priority == NULL) || (Qsize < 2)) return;
-    int i,j;
-    // swapped false means that nothing has been
-    // swapped, so the bubble sort can exit on sensing
-    // it
-    bool swapped;
-
-    // loop through all UserData
-    for(i = 0; i < Qsize-1; i++) {
-        // swapped is the exit condition
-        swapped = false;
-        // loop through numbers falling ahead
-        for(j = 0; j < Qsize-1-i; j++) {
-            // check if UserData[j+1] is of higher priority than UserData[j]
-            if (Q->Priority(LL_GetAtIndex(Q->LL, j+1), LL_GetAtIndex(Q->LL, j))) {
-                // yes, so swap and flag that swapping is being done
-                LL_Swap(Q->LL, j, j+1);
-                swapped = true;
-            }
-        }
-        // if nothing was swapped that means
-        // queue is sorted now, so we are done.
-        if(!swapped) {
+    bool AFirst = Q->Priority(A->Data, B->Data);
+    bool BFirst = Q->Priority(B->Data, A->Data);
+    if (AFirst != BFirst)
+        return AFirst;
+    return A->Order < B->Order;
+}
+
+// SiftUp moves the entry at Index up the heap, shifting each parent
+// of lower priority down into the hole left behind
+void SiftUp (Queue Q, int Index)
+{
+    QueueEntry E = Q->Heap[Index];
+    while (Index > 0)
+    {
+        int Parent = (Index - 1) / 2;
+        if (!Higher (Q, &E, &Q->Heap[Parent]))
             break;
-        }
+        Q->Heap[Index] = Q->Heap[Parent];
+        Index = Parent;
     }
+    Q->Heap[Index] = E;
 }
 
+// SiftDown moves the entry at Index down the heap, shifting the higher
+// priority child up into the hole left behind
+void SiftDown (Queue Q, int Index)
+{
+    QueueEntry E = Q->Heap[Index];
+    for (;;)
+    {
+        int Child = 2 * Index + 1;
+        if (Child >= Q->HeapSize)
+            break;
+        if ((Child + 1 < Q->HeapSize) && Higher (Q, &Q->Heap[Child + 1], &Q->Heap[Child]))
+            Child++;
+        if (!Higher (Q, &Q->Heap[Child], &E))
+            break;
+        Q->Heap[Index] = Q->Heap[Child];
+        Index = Child;
+    }
+    Q->Heap[Index] = E;
+}
+
+// GrowHeap doubles the heap until it can hold Needed entries.
+// realloc keeps the same number of allocations, so AllocationCount
+// is unchanged.
+void GrowHeap (Queue Q, int Needed)
+{
+    if (Needed <= Q->HeapCapacity) return;
+    while (Q->HeapCapacity < Needed)
+        Q->HeapCapacity *= 2;
+    Q->Heap = (QueueEntry *) realloc(Q->Heap, Q->HeapCapacity * sizeof(QueueEntry));
+    assert (Q->Heap != NULL);
+}
+
+// HighestLevel returns the lowest numbered occupied level of a bucket
+// queue.  That is the number of trailing zero bits in the occupancy
+// bitmap, which the compiler can do in a single instruction.
+int HighestLevel (Queue Q)
+{
+    assert ((Q != NULL) && (Q->Occupied != 0));
+#if defined(__GNUC__)
+    return __builtin_ctzll(Q->Occupied);
+#else
+    // count the trailing zeros one bit at a time
+    int level = 0;
+    while ((Q->Occupied & (1ULL << level)) == 0)
+        level++;
+    return level;
+#endif
+}
 
 /* enqueue() calls the linked list to place the UserData at the end of
    the linked list. Since an enqueue is being done, the queue is no longer empty.
-   AdjustQueue is called to apply priority if the user provided
-   a priority comparison function.
+   If the user provided a priority comparison function, the UserData is
+   instead added at the bottom of the heap and sifted up to its place.
+   A bucket queue instead places the UserData at the end of the list for
+   its level and marks that level as occupied.
 */
 void enqueue (Queue Q, UserData D)
 {
     assert (Q != NULL);
+    if (Q->Buckets != NULL)
+    {
+        int level = Q->Level(D);
+        assert ((level >= 0) && (level < Q->NumLevels));
+        LL_AddAtEnd(Q->Buckets[level], D);
+        Q->Occupied |= 1ULL << level;
+        Q->empty = false;
+        if (Q->Stats != NULL)
+            RecordEnqueue (Q, &Q->Rings[level]);
+        return;
+    }
+    if (Q->Heap != NULL)
+    {
+        GrowHeap (Q, Q->HeapSize + 1);
+        Q->Heap[Q->HeapSize].Data = D;
+        Q->Heap[Q->HeapSize].Order = Q->NextOrder++;
+        if (Q->Stats != NULL)
+            Q->Heap[Q->HeapSize].Stamp = RecordEnqueue (Q, NULL);
+        SiftUp (Q, Q->HeapSize++);
+        Q->empty = false;
+        return;
+    }
     LL_AddAtEnd(Q->LL, D);
     Q->empty = false;
-    AdjustQueue (Q);
+    if (Q->Stats != NULL)
+        RecordEnqueue (Q, &Q->Rings[0]);
+}
+
+/* enqueueMany() places n UserData in the queue at once.  For a priority
+   queue, all n are appended to the heap and heap order is restored with a
+   single bottom-up heapify, sifting down every entry that has children,
+   which is O(n) rather than the O(n log n) of n enqueue calls.
+   Simple and bucket queues just append each UserData in turn.
+*/
+void enqueueMany (Queue Q, UserData D[], int n)
+{
+    assert ((Q != NULL) && (n >= 0));
+    if (n == 0) return;
+    if (Q->Heap == NULL)
+    {
+        for (int loop = 0; loop < n; loop++)
+            enqueue (Q, D[loop]);
+        return;
+    }
+    GrowHeap (Q, Q->HeapSize + n);
+    for (int loop = 0; loop < n; loop++)
+    {
+        Q->Heap[Q->HeapSize].Data = D[loop];
+        Q->Heap[Q->HeapSize].Order = Q->NextOrder++;
+        if (Q->Stats != NULL)
+            Q->Heap[Q->HeapSize].Stamp = RecordEnqueue (Q, NULL);
+        Q->HeapSize++;
+    }
+    for (int Index = Q->HeapSize / 2 - 1; Index >= 0; Index--)
+        SiftDown (Q, Index);
+    Q->empty = false;
 }
 
 /*
    dequeue() will fetch the UserData at the front of the linked list and return it to
    caller.  It updates the queue empty status by seeing if the linked list was
    holding only a single item before the removal from the linked list occurs.
+   A bucket queue removes the front of its highest priority occupied level,
+   clearing the level's occupancy bit if that empties the level.
 */
 UserData dequeue (Queue Q)
 {
     assert (Q!= NULL);
+    if (Q->Buckets != NULL)
+    {
+        assert (Q->empty != true);
+        int level = HighestLevel(Q);
+        UserData D = LL_GetFront(Q->Buckets[level], DELETE_NODE);
+        if (LL_Length(Q->Buckets[level]) == 0)
+            Q->Occupied &= ~(1ULL << level);
+        Q->empty = (Q->Occupied == 0);
+        if (Q->Stats != NULL)
+            RecordDequeue (Q, D, PopStamp (&Q->Rings[level]));
+        return D;
+    }
+    if (Q->Heap != NULL)
+    {
+        // take the top of the heap and sift the last entry down from the top
+        assert (Q->HeapSize > 0);
+        UserData D = Q->Heap[0].Data;
+        long long Stamp = Q->Heap[0].Stamp;
+        Q->Heap[0] = Q->Heap[--Q->HeapSize];
+        if (Q->HeapSize > 0)
+            SiftDown (Q, 0);
+        Q->empty = (Q->HeapSize == 0);
+        if (Q->Stats != NULL)
+            RecordDequeue (Q, D, Stamp);
+        return D;
+    }
     Q->empty = LL_Length(Q->LL) == 1 ? true : false;
-    return LL_GetFront(Q->LL, DELETE_NODE);
+    UserData D = LL_GetFront(Q->LL, DELETE_NODE);
+    if (Q->Stats != NULL)
+        RecordDequeue (Q, D, PopStamp (&Q->Rings[0]));
+    return D;
+}
+
+/*
+   dequeueMany() dequeues up to k UserData into out[], highest priority
+   first, and returns how many were dequeued (fewer than k only if the
+   queue ran out of data).
+*/
+int dequeueMany (Queue Q, UserData out[], int k)
+{
+    assert ((Q != NULL) && (k >= 0));
+    int count = 0;
+    while ((count < k) && (Q->empty != true))
+        out[count++] = dequeue (Q);
+    return count;
 }
 /*
    peek() will return the UserData at the front of the queue, but leave the data
@@ -141,5 +432,448 @@ UserData dequeue (Queue Q)
 UserData    peek (Queue Q)
 {
     assert ( (Q != NULL) && (Q->empty != true) );
+    if (Q->Buckets != NULL)
+        return LL_GetFront(Q->Buckets[HighestLevel(Q)], RETAIN_NODE);
+    if (Q->Heap != NULL)
+        return Q->Heap[0].Data;
     return LL_GetFront(Q->LL, RETAIN_NODE);
 }
+
+/*
+   enableQueueStats() allocates the statistics and, for queues kept in
+   linked lists, a StampRing for each list.  Data already in the queue is
+   treated as if it had been enqueued now.
+*/
+void enableQueueStats (Queue Q)
+{
+    assert (Q != NULL);
+    if (Q->Stats != NULL) return;
+    Q->Stats = (QueueStats *) malloc(sizeof(QueueStats));
+    assert (Q->Stats != NULL);
+    AllocationCount++;
+    memset (Q->Stats, 0, sizeof(QueueStats));
+    long long Now = CurrentMicros();
+    int NumRings = (Q->Buckets != NULL) ? Q->NumLevels : (Q->Heap != NULL) ? 0 : 1;
+    Q->Rings = (StampRing *) malloc((NumRings > 0 ? NumRings : 1) * sizeof(StampRing));
+    assert (Q->Rings != NULL);
+    AllocationCount++;
+    for (int ring = 0; ring < NumRings; ring++)
+    {
+        int Length = LL_Length((Q->Buckets != NULL) ? Q->Buckets[ring] : Q->LL);
+        StampRing *Ring = &Q->Rings[ring];
+        Ring->Capacity = (Length < 8) ? 16 : 2 * Length;
+        Ring->Stamps = (long long *) malloc(Ring->Capacity * sizeof(long long));
+        assert (Ring->Stamps != NULL);
+        AllocationCount++;
+        Ring->Head = 0;
+        for (Ring->Count = 0; Ring->Count < Length; Ring->Count++)
+            Ring->Stamps[Ring->Count] = Now;
+        Q->Stats->Depth += Length;
+    }
+    for (int Index = 0; Index < Q->HeapSize; Index++)
+        Q->Heap[Index].Stamp = Now;
+    Q->Stats->Depth += Q->HeapSize;
+    Q->Stats->MaxDepth = Q->Stats->Depth;
+}
+
+/*
+   snapshotQueueStats() copies the statistics so the caller can examine
+   them while the queue carries on
+*/
+void snapshotQueueStats (Queue Q, QueueStats *Out)
+{
+    assert ((Q != NULL) && (Q->Stats != NULL) && (Out != NULL));
+    *Out = *Q->Stats;
+}
+
+/*
+   resetQueueStats() starts the statistics over.  The data in the queue
+   keeps its enqueue times, and the current depth becomes the largest.
+*/
+void resetQueueStats (Queue Q)
+{
+    assert ((Q != NULL) && (Q->Stats != NULL));
+    int Depth = Q->Stats->Depth;
+    memset (Q->Stats, 0, sizeof(QueueStats));
+    Q->Stats->Depth = Q->Stats->MaxDepth = Depth;
+}
+
+/*
+   queueStatsPercentile() walks the histogram for a priority until it has
+   passed the given percentage of the waits, and returns the largest wait
+   counted in the bucket it stopped in
+*/
+long long queueStatsPercentile (QueueStats *S, int priority, double percent)
+{
+    assert (S != NULL);
+    priority = (priority < 0) ? 0 : (priority >= QUEUESTATPRIORITIES) ? QUEUESTATPRIORITIES - 1 : priority;
+    if (S->WaitCount[priority] == 0)
+        return -1;
+    long long Needed = (long long) (S->WaitCount[priority] * percent / 100.0 + 0.5);
+    if (Needed < 1)
+        Needed = 1;
+    long long Seen = 0;
+    for (int Bucket = 0; Bucket < QUEUEHISTBUCKETS; Bucket++)
+    {
+        Seen += S->Histogram[priority][Bucket];
+        if (Seen >= Needed)
+            return (BucketLimit(Bucket) < S->WaitMax[priority]) ? BucketLimit(Bucket) : S->WaitMax[priority];
+    }
+    return S->WaitMax[priority];
+}
+
+// CurrentMicros returns the system's monotonic clock in microseconds
+long long CurrentMicros (void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER Count, Frequency;
+    QueryPerformanceCounter(&Count);
+    QueryPerformanceFrequency(&Frequency);
+    return (long long) (Count.QuadPart * 1000000.0 / Frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+// RecordEnqueue counts the enqueue, tracks the largest depth and stamps it
+long long RecordEnqueue (Queue Q, StampRing *Ring)
+{
+    long long Now = CurrentMicros();
+    Q->Stats->Enqueues++;
+    if (++Q->Stats->Depth > Q->Stats->MaxDepth)
+        Q->Stats->MaxDepth = Q->Stats->Depth;
+    if (Ring != NULL)
+        PushStamp (Ring, Now);
+    return Now;
+}
+
+// RecordDequeue counts the dequeue and adds the wait to its priority's
+// total, largest and histogram
+void RecordDequeue (Queue Q, UserData D, long long Stamp)
+{
+    long long Wait = CurrentMicros() - Stamp;
+    int priority = D.priority;
+    priority = (priority < 0) ? 0 : (priority >= QUEUESTATPRIORITIES) ? QUEUESTATPRIORITIES - 1 : priority;
+    QueueStats *S = Q->Stats;
+    S->Dequeues++;
+    S->Depth--;
+    S->WaitCount[priority]++;
+    S->WaitTotal[priority] += Wait;
+    if (Wait > S->WaitMax[priority])
+        S->WaitMax[priority] = Wait;
+    S->Histogram[priority][HistogramBucket(Wait)]++;
+}
+
+// PushStamp adds a time at the end of the ring, doubling the ring (and
+// unwrapping it) when it is full
+void PushStamp (StampRing *Ring, long long Stamp)
+{
+    if (Ring->Count == Ring->Capacity)
+    {
+        long long *Stamps = (long long *) malloc(2 * Ring->Capacity * sizeof(long long));
+        assert (Stamps != NULL);
+        for (int loop = 0; loop < Ring->Count; loop++)
+            Stamps[loop] = Ring->Stamps[(Ring->Head + loop) % Ring->Capacity];
+        // the new buffer replaces the old one, so AllocationCount is unchanged
+        free (Ring->Stamps);
+        Ring->Stamps = Stamps;
+        Ring->Capacity *= 2;
+        Ring->Head = 0;
+    }
+    Ring->Stamps[(Ring->Head + Ring->Count++) % Ring->Capacity] = Stamp;
+}
+
+// PopStamp removes and returns the time at the front of the ring
+long long PopStamp (StampRing *Ring)
+{
+    assert (Ring->Count > 0);
+    long long Stamp = Ring->Stamps[Ring->Head];
+    Ring->Head = (Ring->Head + 1) % Ring->Capacity;
+    Ring->Count--;
+    return Stamp;
+}
+
+// HistogramBucket counts waits below 16 in buckets of their own.  A larger
+// wait is placed by its highest set bit (its power of two) and the three
+// bits below that (which eighth of the power of two it falls in).
+int HistogramBucket (long long Wait)
+{
+    if (Wait < 16)
+        return (Wait < 0) ? 0 : (int) Wait;
+    int HighBit = 4;
+    while ((HighBit < 63) && (Wait >> (HighBit + 1)) != 0)
+        HighBit++;
+    int Shift = HighBit - 3;
+    int Bucket = (Shift + 1) * 8 + (int) ((Wait >> Shift) & 7);
+    return (Bucket < QUEUEHISTBUCKETS) ? Bucket : QUEUEHISTBUCKETS - 1;
+}
+
+// BucketLimit reverses HistogramBucket, returning the largest wait that
+// falls in a bucket
+long long BucketLimit (int Bucket)
+{
+    if (Bucket < 16)
+        return Bucket;
+    int Shift = Bucket / 8 - 1;
+    return ((long long) (8 + Bucket % 8 + 1) << Shift) - 1;
+}
+
+/*
+ initBlockingQueue() allocates the queue structure and its circular
+ buffer and initializes the lock and the two condition variables.  On
+ POSIX systems the condition variables use the monotonic clock, so that a
+ timed dequeue is not upset by the system time being changed.
+*/
+BlockingQueue initBlockingQueue (int Capacity)
+{
+    assert (Capacity > 0);
+    BlockingQueue BQ = (BlockingQueue) malloc(sizeof(BlockingQueueInfo));
+    assert (BQ != NULL);
+    BQ->Ring = (UserData *) malloc(Capacity * sizeof(UserData));
+    assert (BQ->Ring != NULL);
+    AllocationCount += 2;
+    BQ->Capacity = Capacity;
+    BQ->Head = 0;
+    BQ->Count = 0;
+    BQ->Closed = false;
+#ifdef _WIN32
+    InitializeCriticalSection(&BQ->Lock);
+    InitializeConditionVariable(&BQ->NotEmpty);
+    InitializeConditionVariable(&BQ->NotFull);
+#else
+    pthread_condattr_t Attributes;
+    pthread_condattr_init(&Attributes);
+    pthread_condattr_setclock(&Attributes, CLOCK_MONOTONIC);
+    pthread_mutex_init(&BQ->Lock, NULL);
+    pthread_cond_init(&BQ->NotEmpty, &Attributes);
+    pthread_cond_init(&BQ->NotFull, &Attributes);
+    pthread_condattr_destroy(&Attributes);
+#endif
+    return BQ;
+}
+
+/*
+ enqueueBlocking() waits until there is room or the queue is closed, and
+ then places the UserData after the last one and wakes one dequeuer
+*/
+bool enqueueBlocking (BlockingQueue BQ, UserData D)
+{
+    assert (BQ != NULL);
+    LockQueue (BQ);
+    while ((BQ->Count == BQ->Capacity) && !BQ->Closed)
+        WaitSignal (BQ, &BQ->NotFull, -1);
+    bool Enqueued = !BQ->Closed;
+    if (Enqueued)
+    {
+        BQ->Ring[(BQ->Head + BQ->Count) % BQ->Capacity] = D;
+        BQ->Count++;
+        WakeOne (&BQ->NotEmpty);
+    }
+    UnlockQueue (BQ);
+    return Enqueued;
+}
+
+/*
+ enqueueBlockingMany() fills whatever room there is with the next part of
+ the batch and wakes every dequeuer, repeating until the batch is all
+ enqueued, so a batch larger than the queue is handed over in pieces
+ with the lock taken once per piece rather than once per UserData
+*/
+int enqueueBlockingMany (BlockingQueue BQ, UserData D[], int n)
+{
+    assert ((BQ != NULL) && (n >= 0));
+    int Done = 0;
+    LockQueue (BQ);
+    while ((Done < n) && !BQ->Closed)
+    {
+        if (BQ->Count == BQ->Capacity)
+        {
+            WaitSignal (BQ, &BQ->NotFull, -1);
+            continue;
+        }
+        int Room = BQ->Capacity - BQ->Count;
+        int Move = (n - Done < Room) ? n - Done : Room;
+        for (int loop = 0; loop < Move; loop++)
+            BQ->Ring[(BQ->Head + BQ->Count + loop) % BQ->Capacity] = D[Done + loop];
+        BQ->Count += Move;
+        Done += Move;
+        WakeAll (&BQ->NotEmpty);
+    }
+    UnlockQueue (BQ);
+    return Done;
+}
+
+/*
+ dequeueBlocking() waits without a time limit
+*/
+bool dequeueBlocking (BlockingQueue BQ, UserData *D)
+{
+    return dequeueTimed (BQ, D, -1) == BLOCKING_OK;
+}
+
+/*
+ dequeueTimed() waits until there is data, the queue is closed or the
+ time is up.  A negative TimeoutMs waits for as long as it takes.
+*/
+BlockingStatus dequeueTimed (BlockingQueue BQ, UserData *D, long TimeoutMs)
+{
+    assert ((BQ != NULL) && (D != NULL));
+    long long Deadline = (TimeoutMs < 0) ? -1 : CurrentMicros() + TimeoutMs * 1000LL;
+    BlockingStatus Status = BLOCKING_OK;
+    LockQueue (BQ);
+    while ((BQ->Count == 0) && !BQ->Closed)
+        if (!WaitSignal (BQ, &BQ->NotEmpty, Deadline) && (BQ->Count == 0))
+            break;
+    if (BQ->Count > 0)
+        TakeBlocking (BQ, D, 1);
+    else
+        Status = BQ->Closed ? BLOCKING_CLOSED : BLOCKING_TIMEDOUT;
+    UnlockQueue (BQ);
+    return Status;
+}
+
+/*
+ dequeueBlockingMany() waits until there is data or the queue is closed
+ and takes all that is there, up to k, under one hold of the lock
+*/
+int dequeueBlockingMany (BlockingQueue BQ, UserData out[], int k)
+{
+    assert ((BQ != NULL) && (k > 0));
+    LockQueue (BQ);
+    while ((BQ->Count == 0) && !BQ->Closed)
+        WaitSignal (BQ, &BQ->NotEmpty, -1);
+    int Taken = TakeBlocking (BQ, out, k);
+    UnlockQueue (BQ);
+    return Taken;
+}
+
+/*
+ drainBlockingQueue() takes whatever data is there, up to k, without waiting
+*/
+int drainBlockingQueue (BlockingQueue BQ, UserData out[], int k)
+{
+    assert ((BQ != NULL) && (k >= 0));
+    LockQueue (BQ);
+    int Taken = TakeBlocking (BQ, out, k);
+    UnlockQueue (BQ);
+    return Taken;
+}
+
+/*
+ closeBlockingQueue() marks the queue closed and wakes all waiting threads:
+ enqueuers give up and dequeuers take what is left or see the queue is closed
+*/
+void closeBlockingQueue (BlockingQueue BQ)
+{
+    assert (BQ != NULL);
+    LockQueue (BQ);
+    BQ->Closed = true;
+    WakeAll (&BQ->NotEmpty);
+    WakeAll (&BQ->NotFull);
+    UnlockQueue (BQ);
+}
+
+/*
+ deleteBlockingQueue() releases the lock and condition variables and frees
+ the buffer and the queue.  It returns NULL to indicate that there is no
+ longer a queue.
+*/
+BlockingQueue deleteBlockingQueue (BlockingQueue BQ)
+{
+    assert (BQ != NULL);
+#ifdef _WIN32
+    DeleteCriticalSection(&BQ->Lock);
+#else
+    pthread_mutex_destroy(&BQ->Lock);
+    pthread_cond_destroy(&BQ->NotEmpty);
+    pthread_cond_destroy(&BQ->NotFull);
+#endif
+    free (BQ->Ring);
+    free (BQ);
+    AllocationCount -= 2;
+    return NULL;
+}
+
+// LockQueue takes the queue's lock, waiting for any other holder
+void LockQueue (BlockingQueue BQ)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&BQ->Lock);
+#else
+    pthread_mutex_lock(&BQ->Lock);
+#endif
+}
+
+// UnlockQueue releases the queue's lock
+void UnlockQueue (BlockingQueue BQ)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&BQ->Lock);
+#else
+    pthread_mutex_unlock(&BQ->Lock);
+#endif
+}
+
+// WaitSignal waits on a condition variable, converting the deadline to
+// the milliseconds left (Windows) or to an absolute monotonic time (POSIX).
+// A wait can end without the signal being given, so callers check their
+// condition again after it returns.
+bool WaitSignal (BlockingQueue BQ, QueueSignal *Signal, long long Deadline)
+{
+#ifdef _WIN32
+    DWORD Wait = INFINITE;
+    if (Deadline >= 0)
+    {
+        long long Left = Deadline - CurrentMicros();
+        if (Left <= 0)
+            return false;
+        Wait = (DWORD) ((Left + 999) / 1000);
+    }
+    return SleepConditionVariableCS(Signal, &BQ->Lock, Wait) || (GetLastError() != ERROR_TIMEOUT);
+#else
+    if (Deadline < 0)
+        return pthread_cond_wait(Signal, &BQ->Lock) == 0;
+    struct timespec ts;
+    ts.tv_sec = Deadline / 1000000;
+    ts.tv_nsec = (Deadline % 1000000) * 1000;
+    return pthread_cond_timedwait(Signal, &BQ->Lock, &ts) == 0;
+#endif
+}
+
+// WakeOne gives the signal to one waiting thread, if there is one
+void WakeOne (QueueSignal *Signal)
+{
+#ifdef _WIN32
+    WakeConditionVariable(Signal);
+#else
+    pthread_cond_signal(Signal);
+#endif
+}
+
+// WakeAll gives the signal to every waiting thread
+void WakeAll (QueueSignal *Signal)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(Signal);
+#else
+    pthread_cond_broadcast(Signal);
+#endif
+}
+
+// TakeBlocking copies from the front of the circular buffer and wakes one
+// enqueuer for a single UserData or every enqueuer when more room was made
+int TakeBlocking (BlockingQueue BQ, UserData out[], int k)
+{
+    int Taken = (BQ->Count < k) ? BQ->Count : k;
+    for (int loop = 0; loop < Taken; loop++)
+        out[loop] = BQ->Ring[(BQ->Head + loop) % BQ->Capacity];
+    BQ->Head = (BQ->Head + Taken) % BQ->Capacity;
+    BQ->Count -= Taken;
+    if (Taken == 1)
+        WakeOne (&BQ->NotFull);
+    else if (Taken > 1)
+        WakeAll (&BQ->NotFull);
+    return Taken;
+}
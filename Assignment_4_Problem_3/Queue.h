@@ -11,6 +11,18 @@
 #include "LinkedList.h"
 // The Queue empty() call returns a boolean
 #include <stdbool.h>
+// A BlockingQueue is shared between threads, so it needs a lock and
+// condition variables: Windows provides its own, elsewhere POSIX threads
+// are used (link with -pthread)
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION QueueLock;
+typedef CONDITION_VARIABLE QueueSignal;
+#else
+#include <pthread.h>
+typedef pthread_mutex_t QueueLock;
+typedef pthread_cond_t QueueSignal;
+#endif
 
 // To support maintaining priority in the queue, we declare a
 // typedef that says "UserComparison is any function that, when
@@ -19,28 +31,134 @@
 // and false if not
 typedef bool UserComparison (UserData first, UserData second);
 
+// When there are only a handful of priority levels, the queue can
+// instead keep one FIFO per level.  UserPriorityLevel is any function
+// that, when called with a UserData, returns the level the data belongs
+// to (0 is the highest priority level and is dequeued first)
+typedef int UserPriorityLevel (UserData D);
+
+// MAXBUCKETLEVELS is the largest number of levels a bucket queue supports.
+// It matches the number of bits in the occupancy bitmap used to find the
+// highest priority non-empty level
+#define MAXBUCKETLEVELS 64
+
+// A queue with a priority comparison keeps its data in a binary heap.
+// Each heap entry holds the user's data and the order it was enqueued in,
+// so that data of equal priority leaves the queue oldest first.  Stamp is
+// the time it was enqueued, filled in only when statistics are enabled.
+typedef struct {
+    UserData Data;
+    unsigned long Order;
+    long long Stamp;
+} QueueEntry;
+
+// Statistics on how long data waits in a queue are kept separately for
+// each priority from 0 to QUEUESTATPRIORITIES-1 (other priorities are
+// counted with the nearest of these).  Wait times are in microseconds and
+// are counted in a histogram whose buckets are exact below 16 and then
+// split each power of two into 8 equal buckets, so any recorded wait is
+// within 12.5% of its bucket's value.  Waits of 2^41 microseconds (about
+// 25 days) or more are counted in the last bucket.
+#define QUEUESTATPRIORITIES 16
+#define QUEUEHISTBUCKETS 312
+
+// QueueStats holds the statistics gathered since they were enabled or
+// last reset: how many enqueues and dequeues were done, the current and
+// largest number of items in the queue, and for each priority the number
+// of dequeues, the total and largest wait and the wait time histogram.
+typedef struct {
+    long long Enqueues;
+    long long Dequeues;
+    int Depth;
+    int MaxDepth;
+    long long WaitCount[QUEUESTATPRIORITIES];
+    long long WaitTotal[QUEUESTATPRIORITIES];
+    long long WaitMax[QUEUESTATPRIORITIES];
+    long long Histogram[QUEUESTATPRIORITIES][QUEUEHISTBUCKETS];
+} QueueStats;
+
+// A StampRing holds the enqueue times of the data in one linked list, in
+// the same order as the list, as a circular buffer of Capacity times
+// starting at Head.  The heap keeps its times in its entries instead.
+typedef struct {
+    long long *Stamps;
+    int Head;
+    int Count;
+    int Capacity;
+} StampRing;
+
 // This is the layout of a priority queue.  Notice that it contains
 // a pointer to our underlying linked list, a simple boolean
 // to indicate if our queue is empty (true) or not empty (false) and
 // a pointer to the user's function called to support prioritization
 // Notice the use of the typedef UserComparison
+// When a comparison is provided, LL is NULL and the data is held in Heap,
+// an array of HeapCapacity entries of which HeapSize are in use.
+// A bucket queue leaves LL and Priority NULL and instead holds the user's
+// level function, one linked list per level and a bitmap with a bit set for
+// every level whose linked list currently holds data
+// Stats is NULL unless statistics have been enabled, in which case Rings
+// holds the enqueue times for the single list or for each level's list
 typedef struct {
     LLInfoPtr LL;
     bool empty;
     UserComparison *Priority;
+    QueueEntry *Heap;
+    int HeapSize;
+    int HeapCapacity;
+    unsigned long NextOrder;
+    UserPriorityLevel *Level;
+    int NumLevels;
+    LLInfoPtr *Buckets;
+    unsigned long long Occupied;
+    QueueStats *Stats;
+    StampRing *Rings;
 } QueueInfo, *Queue;
 
+// A BlockingQueue is a bounded FIFO that any number of threads may enqueue
+// to and dequeue from at the same time, so that one thread can read and
+// parse input while others process it.  It holds at most Capacity
+// UserData in the circular buffer Ring, starting at Head.  A thread that
+// enqueues to a full queue waits (on NotFull) until there is room, so a
+// fast reader cannot run ahead of the workers by more than Capacity items,
+// and a thread that dequeues from an empty queue waits (on NotEmpty) for
+// data.  Once Closed, nothing more may be enqueued and dequeues return
+// what is left before reporting that the queue is closed.
+typedef struct {
+    UserData *Ring;
+    int Capacity;
+    int Head;
+    int Count;
+    bool Closed;
+    QueueLock Lock;
+    QueueSignal NotEmpty;
+    QueueSignal NotFull;
+} BlockingQueueInfo, *BlockingQueue;
+
+// BlockingStatus is what dequeueTimed() returns: data was dequeued, the
+// time ran out first, or the queue is closed and has no data left
+typedef enum {BLOCKING_OK, BLOCKING_TIMEDOUT, BLOCKING_CLOSED} BlockingStatus;
+
 
 // initQueue() allocates a priority queue and initializes the
 // priority queue structure
    Queue initQueue (UserComparison UserOrder);
+// initBucketQueue() allocates a priority queue that keeps one FIFO for each
+// of NumLevels levels, using UserLevel to find the level of enqueued data
+   Queue initBucketQueue (UserPriorityLevel UserLevel, int NumLevels);
 // empty() returns the boolean for the Queue Q (true is empty, false is not empty)
 bool        empty(Queue Q);
 // enqueue() places the UserData at the end of the underlying LL
 void        enqueue (Queue Q, UserData D);
+// enqueueMany() places n UserData in the queue, restoring priority
+// order once for the whole batch
+void        enqueueMany (Queue Q, UserData D[], int n);
 // dequeue() returns the UserData on the top of the queue and deletes
 // the data from the queue
 UserData    dequeue (Queue Q);
+// dequeueMany() dequeues up to k UserData into out[] and returns how
+// many were dequeued
+int         dequeueMany (Queue Q, UserData out[], int k);
 // peek() returns the UserData on the top of the queue but will not
 // delete it from the queue
 UserData    peek (Queue Q);
@@ -48,4 +166,45 @@ UserData    peek (Queue Q);
 // to initQueue()
 Queue deleteQueue(Queue Q);
 
+// enableQueueStats() starts gathering wait time and depth statistics.
+// Until it is called, a queue does no extra work beyond checking a pointer.
+void        enableQueueStats (Queue Q);
+// snapshotQueueStats() copies the statistics gathered so far into *Out
+void        snapshotQueueStats (Queue Q, QueueStats *Out);
+// resetQueueStats() clears the statistics, keeping only the current depth
+void        resetQueueStats (Queue Q);
+// queueStatsPercentile() returns the wait time (in microseconds) that the
+// given percentage of the waits at a priority did not exceed, or -1 if no
+// data of that priority has been dequeued
+long long   queueStatsPercentile (QueueStats *S, int priority, double percent);
+
+// initBlockingQueue() allocates an empty blocking queue holding at most
+// Capacity UserData
+BlockingQueue initBlockingQueue (int Capacity);
+// enqueueBlocking() places the UserData at the end of the queue, waiting
+// while the queue is full.  It returns false if the queue is closed.
+bool        enqueueBlocking (BlockingQueue BQ, UserData D);
+// enqueueBlockingMany() places n UserData at the end of the queue, as many
+// at a time as there is room for, and returns how many were enqueued
+// (fewer than n only if the queue was closed)
+int         enqueueBlockingMany (BlockingQueue BQ, UserData D[], int n);
+// dequeueBlocking() waits for data and removes it from the front of the
+// queue into *D.  It returns false once the queue is closed and empty.
+bool        dequeueBlocking (BlockingQueue BQ, UserData *D);
+// dequeueTimed() is dequeueBlocking() waiting no more than TimeoutMs
+// milliseconds for data
+BlockingStatus dequeueTimed (BlockingQueue BQ, UserData *D, long TimeoutMs);
+// dequeueBlockingMany() waits for data and then dequeues as much as is
+// there, up to k, into out[].  It returns how many were dequeued, which is
+// 0 only once the queue is closed and empty.
+int         dequeueBlockingMany (BlockingQueue BQ, UserData out[], int k);
+// drainBlockingQueue() dequeues up to k UserData into out[] without
+// waiting and returns how many were dequeued
+int         drainBlockingQueue (BlockingQueue BQ, UserData out[], int k);
+// closeBlockingQueue() stops further enqueues and wakes every waiting
+// thread.  Data already queued can still be dequeued.
+void        closeBlockingQueue (BlockingQueue BQ);
+// deleteBlockingQueue() frees the queue, which no thread may still be using
+BlockingQueue deleteBlockingQueue (BlockingQueue BQ);
+
 #endif // QUEUE_H_INCLUDED
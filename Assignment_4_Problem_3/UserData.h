@@ -5,10 +5,13 @@
 // contains.
 //
 
-// User data in each node contains a priority and an associated time
+// User data in each node contains a priority and an associated time.
+// id lets a caller that keeps more information about the data elsewhere
+// (such as the scheduler simulation's task table) find it again
 typedef struct {
     int priority;
     char time[80];
+    int id;
 } UserData, *UserDataPtr;
 
 
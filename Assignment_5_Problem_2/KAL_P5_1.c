@@ -7,6 +7,11 @@
 // An additonal modification is the addition of the parent linkage
 // that can be used to traverse from a node back through its parent.
 //
+// The tree is read by buildTreeIterative, which keeps its own stack
+// instead of recursing and reads the file a buffer at a time, so a file
+// describing a very deep tree can still be read.  The recursive buildTree
+// it replaces is kept for comparison.
+//
 // This program is designed to demonstrate building a binary tree. It
 // consists of functions and definitions for the binary tree including
 // building a tree, pre-order/in-order/post-order transversal, visit
@@ -21,8 +26,10 @@
 // we will use strcpy() and strcmp() from string.h
 #include <string.h>
 // stdlib provides the definition of NULL and the declarations for
-// malloc() and free()
+// malloc(), realloc() and free()
 #include <stdlib.h>
+// we will use isspace() from ctype.h to find where words end
+#include <ctype.h>
 
 // this is an int constant that limits a node/read-in-word's name to a maximum
 // length, or number of characters, to this set value
@@ -30,6 +37,12 @@
 // this is a string constant that sets the name of the file to open and read in
 // words from
 #define FILENAME "btree.in"
+// this is an int constant that sets how many bytes of the file are read
+// into memory at a time when picking out words
+#define TOKENBUFFERSIZE 65536
+// this is an int constant that sets how many links the stack used by
+// buildTreeIterative can hold before it has to be made larger
+#define INITIALSTACKSIZE 64
 
 // To make sure we are allocating and deallocating dynamic memory,
 // variable AllocationCount is declared and referenced by any other
@@ -64,12 +77,40 @@ typedef struct {
     TreeNodePtr root;
 } BinaryTree;
 
+// TokenReader struct holds the file words are read from and a buffer of
+// bytes already read from it, so that words are picked out of memory
+// rather than with one fscanf() call each. next is the position of the
+// next unused byte in the buffer and end is how many bytes it holds
+typedef struct {
+    FILE * in;
+    char buffer[TOKENBUFFERSIZE];
+    int next;
+    int end;
+} TokenReader;
+
+// PendingLink struct is one entry on the stack used by buildTreeIterative.
+// It holds the address of a left or right link (or the root) that is still
+// to be filled in and the node that link belongs to, which becomes the
+// parent of the node read for it
+typedef struct {
+    TreeNodePtr *link;
+    TreeNodePtr parent;
+} PendingLink;
+
 // buildTree creates all nodes for a binary tree and assigns each one a word
 // with maximum length as its name. The word is grabbed from an opened file
 // and this function allocates memory for each newly created
 // node. It takes a file name and a binary tree root node as arguments.
 // It returns the node which gets created and assigned a name.
 TreeNodePtr buildTree         (FILE * in, TreeNodePtr nodeParent);
+// buildTreeIterative builds the same tree as buildTree from the same file,
+// but keeps the links still to be filled in on a stack of its own rather
+// than recursing, so the depth of the tree is limited only by memory.
+// It takes the file and returns the root node.
+TreeNodePtr buildTreeIterative (FILE * in);
+// nextToken takes a TokenReader and a char array, fills the array with the
+// next word of the file and returns 1, or returns 0 if there are no words left
+int         nextToken         (TokenReader * reader, char word[]);
 // Pre-order traversal of a tree.
 // First visit the root node, then the left subtree and finally the right subtree.
 // Every node may represent a subtree itself.
@@ -123,10 +164,9 @@ int main()
     BinaryTree bt;
     // build the binary tree using the newly initialized binary tree
     // create nodes for each of the words contained in the file
-    // it takes a NULL argument along with the file name because
-    // the node parent (in this case the root) is still NULL
-    // from being newly initialized
-    bt.root = buildTree(in, NULL);
+    // the iterative builder is used so that a tree of any depth can
+    // be read; the root node's parent is NULL
+    bt.root = buildTreeIterative(in);
     printf("Allocation count after tree build is %d\n", AllocationCount);
     // Dp a pre-order traversal of a tree.
     // First visit the root node, then the left subtree and finally the right subtree.
@@ -198,6 +238,125 @@ TreeNodePtr buildTree   (FILE * in, TreeNodePtr nodeParent)
     return p;
 } //end buildTree
 
+// buildTreeIterative takes an opened file as its argument.
+// It reads the same preorder list of names and "@" characters as
+// buildTree and builds the same tree with the same parent links.
+// Instead of calling itself for the left and then the right subtree,
+// it keeps a stack of the links still waiting for a node. The root link
+// starts on the stack. Each word read fills in the link on top of the
+// stack: "@" leaves it NULL, while a name creates a node and pushes the
+// new node's right link and then its left link, so the left subtree is
+// read first just as buildTree does. Links still waiting when the file
+// runs out are left NULL.
+// The stack and the TokenReader are dynamically allocated and freed
+// before returning, so only the nodes remain in AllocationCount.
+// Because words are read a buffer at a time, the file may have been read
+// past the end of the tree when this function returns.
+TreeNodePtr buildTreeIterative (FILE * in)
+{
+    // the tree is empty until the root link is filled in
+    TreeNodePtr root = NULL;
+    // initialize a string variable to hold MaxWordSize number of
+    // characters (20) and a NULL (zero byte) at the end
+    char str[MaxWordSize+1];
+    // allocate the reader that buffers the file and the stack
+    int stackSize = INITIALSTACKSIZE;
+    TokenReader * reader = (TokenReader *) malloc(sizeof(TokenReader));
+    PendingLink * stack = (PendingLink *) malloc(stackSize * sizeof(PendingLink));
+    if ((reader == NULL) || (stack == NULL)) {
+        printf ("Unable to allocate memory to build the tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount += 2;
+    reader -> in = in;
+    reader -> next = 0;
+    reader -> end = 0;
+    // push the root link, which has no parent
+    int top = 0;
+    stack[top].link = &root;
+    stack[top].parent = NULL;
+    top++;
+    // fill in links until none are waiting or the words run out
+    while ((top > 0) && nextToken(reader, str)) {
+        // take the link on top of the stack
+        PendingLink pending = stack[--top];
+        // an "@" character means this link stays NULL
+        if (strcmp(str, "@") == 0) continue;
+        // allocate memory for the node
+        TreeNodePtr p = (TreeNodePtr) malloc(sizeof(TreeNode));
+        // increase AllocationCount to reflect the newly created memory
+        AllocationCount++;
+        // set the node's name, its parent and, until they are read,
+        // empty subtrees
+        strcpy(p -> data.word, str);
+        p -> parent = pending.parent;
+        p -> left = NULL;
+        p -> right = NULL;
+        // link the node in where it was waited for
+        *pending.link = p;
+        // make room for two more links; the new stack replaces the old
+        // one, so AllocationCount is unchanged
+        if (top + 2 > stackSize) {
+            stackSize *= 2;
+            stack = (PendingLink *) realloc(stack, stackSize * sizeof(PendingLink));
+            if (stack == NULL) {
+                printf ("Unable to allocate memory to build the tree... exiting\n");
+                exit (0);
+            }
+        }
+        // push the right link first so the left link is filled in next
+        stack[top].link = &p -> right;
+        stack[top].parent = p;
+        top++;
+        stack[top].link = &p -> left;
+        stack[top].parent = p;
+        top++;
+    }
+    // free the stack and the reader, decreasing AllocationCount
+    free(stack);
+    free(reader);
+    AllocationCount -= 2;
+    // return the root node
+    return root;
+} //end buildTreeIterative
+
+// nextToken takes a TokenReader and a char array as arguments.
+// It skips any white space and then copies the characters up to the next
+// white space (or the end of the file) into the array, keeping only the
+// first MaxWordSize of a longer word. Whenever the buffer has been used
+// up, the next TOKENBUFFERSIZE bytes are read from the file with one
+// fread() call.
+// It returns 1 if a word was found and 0 at the end of the file.
+int nextToken (TokenReader * reader, char word[])
+{
+    // the number of characters kept and the number seen in this word
+    int length = 0;
+    int seen = 0;
+    while (1) {
+        // refill the buffer once all of it has been used
+        if (reader -> next == reader -> end) {
+            reader -> end = (int) fread(reader -> buffer, 1, TOKENBUFFERSIZE, reader -> in);
+            reader -> next = 0;
+            // stop at the end of the file
+            if (reader -> end == 0) break;
+        }
+        char c = reader -> buffer[reader -> next];
+        // white space ends a word, or is skipped before one starts
+        if (isspace((unsigned char) c)) {
+            if (seen > 0) break;
+            reader -> next++;
+            continue;
+        }
+        // keep the character if there is room for it
+        if (length < MaxWordSize) word[length++] = c;
+        seen++;
+        reader -> next++;
+    }
+    // end the string with a NULL (zero byte)
+    word[length] = '\0';
+    return (seen > 0);
+} //end nextToken
+
  // deleteTree() uses recursion to search the tree, delete and free up all of its nodes
  // It returns nothing
 void deleteTree(TreeNodePtr rootNode)
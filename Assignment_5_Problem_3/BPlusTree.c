@@ -0,0 +1,307 @@
+// BPlusTree.c keeps integer keys and their counts in a B+tree.
+//
+// Keys are added top down: on the way down to the leaf a key belongs in,
+// any full node is split in two before it is entered, moving its middle
+// key up into its parent (which cannot be full, having just been checked).
+// So there is always room for the new key in its leaf and nothing has to
+// be fixed on the way back up.  A full root is split by giving the tree a
+// new root above it, which is the only way the tree grows taller.
+
+// printf provides the error message when memory runs out
+#include <stdio.h>
+// stdlib provides malloc(), free() and exit()
+#include <stdlib.h>
+// string.h provides memmove() and memcpy()
+#include <string.h>
+// the tree's own declarations are included for consistency checking
+#include "BPlusTree.h"
+
+// To make sure we are allocating and deallocating dynamic memory,
+// AllocationCount (defined with main) is updated for every node, the tree
+// itself and the scratch arrays of a bulk load
+extern int AllocationCount;
+
+// newNode is a local function that allocates an empty leaf or inner node
+static BPlusNode * newNode (BPlusTree tree, bool leaf);
+// firstNotLess is a local function that returns the index of the first of
+// a node's keys not less than key (numKeys if there is none)
+static int firstNotLess (BPlusNode * node, int key);
+// childFor is a local function that returns the index of the child of an
+// inner node whose keys include key
+static int childFor (BPlusNode * node, int key);
+// splitChild is a local function that splits the full child i of parent
+// into two, adding the key that separates them to parent
+static void splitChild (BPlusTree tree, BPlusNode * parent, int i);
+// deleteNodes is a local function that frees a node and everything below it
+static void deleteNodes (BPlusNode * node);
+// allocateScratch is a local function that allocates a scratch array for
+// a bulk load
+static void * allocateScratch (size_t size);
+
+// initBPlusTree allocates a tree with no nodes
+BPlusTree initBPlusTree (void)
+{
+    BPlusTree tree = (BPlusTree) malloc(sizeof(BPlusTreeInfo));
+    if (tree == NULL) {
+        printf ("Unable to create a B+tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    tree -> root = NULL;
+    tree -> height = 0;
+    tree -> numNodes = 0;
+    tree -> numKeys = 0;
+    return tree;
+} // end initBPlusTree
+
+// bulkLoadBPlusTree builds the tree from the bottom up.  The keys are
+// shared out as evenly as possible among just enough leaves to hold them,
+// which are linked in order.  Then, one level at a time, the nodes of the
+// level are shared out among just enough parents to hold them, each
+// parent's keys being the smallest keys below each of its children but the
+// first, until a level has only one node, the root.  Sharing out evenly
+// means no node is less than half full
+BPlusTree bulkLoadBPlusTree (int keys[], int counts[], int n)
+{
+    BPlusTree tree = initBPlusTree();
+    if (n == 0) return tree;
+    tree -> numKeys = n;
+
+    // level holds the nodes of the level being built and smallest the
+    // smallest key below each of them
+    int numLeaves = (n + BPLUSFANOUT - 1) / BPLUSFANOUT;
+    BPlusNode ** level = (BPlusNode **) allocateScratch(numLeaves * sizeof(BPlusNode *));
+    int * smallest = (int *) allocateScratch(numLeaves * sizeof(int));
+    int used = 0;
+    for (int i = 0; i < numLeaves; i++) {
+        BPlusNode * leaf = newNode(tree, true);
+        // the first n % numLeaves leaves take one extra key
+        leaf -> numKeys = n / numLeaves + (i < n % numLeaves);
+        memcpy(leaf -> keys, keys + used, leaf -> numKeys * sizeof(int));
+        memcpy(leaf -> counts, counts + used, leaf -> numKeys * sizeof(int));
+        used += leaf -> numKeys;
+        if (i > 0) level[i - 1] -> next = leaf;
+        level[i] = leaf;
+        smallest[i] = leaf -> keys[0];
+    }
+    tree -> height = 1;
+
+    int count = numLeaves;
+    while (count > 1) {
+        int numParents = (count + BPLUSFANOUT) / (BPLUSFANOUT + 1);
+        int child = 0;
+        for (int i = 0; i < numParents; i++) {
+            BPlusNode * parent = newNode(tree, false);
+            int numChildren = count / numParents + (i < count % numParents);
+            parent -> numKeys = numChildren - 1;
+            for (int c = 0; c < numChildren; c++) {
+                parent -> children[c] = level[child + c];
+                if (c > 0) parent -> keys[c - 1] = smallest[child + c];
+            }
+            // the parents replace the level's nodes from the front, each
+            // one after all of the nodes it has taken as children
+            smallest[i] = smallest[child];
+            level[i] = parent;
+            child += numChildren;
+        }
+        count = numParents;
+        tree -> height++;
+    }
+    tree -> root = level[0];
+    free(level);
+    free(smallest);
+    AllocationCount -= 2;
+    return tree;
+} // end bulkLoadBPlusTree
+
+// bPlusFind goes down to the leaf the key belongs in and looks for it there
+int * bPlusFind (BPlusTree tree, int key)
+{
+    BPlusNode * node = tree -> root;
+    if (node == NULL) return NULL;
+    while (!node -> leaf) node = node -> children[childFor(node, key)];
+    int i = firstNotLess(node, key);
+    if ((i < node -> numKeys) && (node -> keys[i] == key)) return &node -> counts[i];
+    return NULL;
+} // end bPlusFind
+
+// bPlusFindOrInsert first looks for the key without changing the tree,
+// since most keys counted are usually already there.  A new key is added
+// by going down again, splitting full nodes on the way, and moving the
+// larger keys of its leaf along to make room for it
+int * bPlusFindOrInsert (BPlusTree tree, int key)
+{
+    int * count = bPlusFind(tree, key);
+    if (count != NULL) return count;
+
+    if (tree -> root == NULL) {
+        tree -> root = newNode(tree, true);
+        tree -> height = 1;
+    } else if (tree -> root -> numKeys == BPLUSFANOUT) {
+        // the only child of the new root is the old root, which is split
+        BPlusNode * root = newNode(tree, false);
+        root -> children[0] = tree -> root;
+        tree -> root = root;
+        tree -> height++;
+        splitChild(tree, root, 0);
+    }
+    BPlusNode * node = tree -> root;
+    while (!node -> leaf) {
+        int i = childFor(node, key);
+        if (node -> children[i] -> numKeys == BPLUSFANOUT) {
+            splitChild(tree, node, i);
+            // the key may belong in the new right half
+            if (key >= node -> keys[i]) i++;
+        }
+        node = node -> children[i];
+    }
+    int i = firstNotLess(node, key);
+    int after = node -> numKeys - i;
+    memmove(node -> keys + i + 1, node -> keys + i, after * sizeof(int));
+    memmove(node -> counts + i + 1, node -> counts + i, after * sizeof(int));
+    node -> keys[i] = key;
+    node -> counts[i] = 0;
+    node -> numKeys++;
+    tree -> numKeys++;
+    return &node -> counts[i];
+} // end bPlusFindOrInsert
+
+// bPlusSeek goes down to the leaf the key belongs in and sets the cursor at
+// the first key there not less than it, which may be the first key of the
+// next leaf
+void bPlusSeek (BPlusTree tree, int key, BPlusCursor * cursor)
+{
+    BPlusNode * node = tree -> root;
+    cursor -> leaf = NULL;
+    cursor -> index = 0;
+    if (node == NULL) return;
+    while (!node -> leaf) node = node -> children[childFor(node, key)];
+    cursor -> leaf = node;
+    cursor -> index = firstNotLess(node, key);
+    if (cursor -> index == node -> numKeys) {
+        cursor -> leaf = node -> next;
+        cursor -> index = 0;
+    }
+} // end bPlusSeek
+
+// bPlusNext reads the cursor's key and count and steps to the next key,
+// following the link to the next leaf at the end of a leaf
+bool bPlusNext (BPlusCursor * cursor, int * key, int * count)
+{
+    if (cursor -> leaf == NULL) return false;
+    *key = cursor -> leaf -> keys[cursor -> index];
+    *count = cursor -> leaf -> counts[cursor -> index];
+    if (++cursor -> index == cursor -> leaf -> numKeys) {
+        cursor -> leaf = cursor -> leaf -> next;
+        cursor -> index = 0;
+    }
+    return true;
+} // end bPlusNext
+
+// deleteBPlusTree frees the nodes and then the tree
+BPlusTree deleteBPlusTree (BPlusTree tree)
+{
+    if (tree -> root != NULL) deleteNodes(tree -> root);
+    AllocationCount -= tree -> numNodes;
+    free(tree);
+    AllocationCount--;
+    return NULL;
+} // end deleteBPlusTree
+
+// newNode allocates a node with no keys and, for a leaf, no next leaf
+BPlusNode * newNode (BPlusTree tree, bool leaf)
+{
+    BPlusNode * node = (BPlusNode *) malloc(sizeof(BPlusNode));
+    if (node == NULL) {
+        printf ("Unable to allocate memory for a B+tree node... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    tree -> numNodes++;
+    node -> numKeys = 0;
+    node -> leaf = leaf;
+    if (leaf) node -> next = NULL;
+    return node;
+} // end newNode
+
+// firstNotLess does a binary search of the node's keys
+int firstNotLess (BPlusNode * node, int key)
+{
+    int low = 0, high = node -> numKeys;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (node -> keys[middle] < key) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+} // end firstNotLess
+
+// childFor does a binary search for the first key greater than key.  The
+// child before that key is the one whose keys include key
+int childFor (BPlusNode * node, int key)
+{
+    int low = 0, high = node -> numKeys;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (node -> keys[middle] <= key) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+} // end childFor
+
+// splitChild moves the upper half of the full child into a new node just
+// after it.  A leaf keeps all of its keys in the leaves, so a copy of the
+// new leaf's first key goes up, and the new leaf is linked in after the old
+// one.  An inner node's middle key instead moves up itself, the keys on
+// either side of it staying with their children
+void splitChild (BPlusTree tree, BPlusNode * parent, int i)
+{
+    BPlusNode * child = parent -> children[i];
+    BPlusNode * right = newNode(tree, child -> leaf);
+    int middle = BPLUSFANOUT / 2;
+    int separator;
+    if (child -> leaf) {
+        right -> numKeys = BPLUSFANOUT - middle;
+        memcpy(right -> keys, child -> keys + middle, right -> numKeys * sizeof(int));
+        memcpy(right -> counts, child -> counts + middle, right -> numKeys * sizeof(int));
+        right -> next = child -> next;
+        child -> next = right;
+        separator = right -> keys[0];
+    } else {
+        right -> numKeys = BPLUSFANOUT - middle - 1;
+        memcpy(right -> keys, child -> keys + middle + 1, right -> numKeys * sizeof(int));
+        memcpy(right -> children, child -> children + middle + 1,
+               (right -> numKeys + 1) * sizeof(BPlusNode *));
+        separator = child -> keys[middle];
+    }
+    child -> numKeys = middle;
+
+    // make room in the parent for the separator and the new child
+    int after = parent -> numKeys - i;
+    memmove(parent -> keys + i + 1, parent -> keys + i, after * sizeof(int));
+    memmove(parent -> children + i + 2, parent -> children + i + 1, after * sizeof(BPlusNode *));
+    parent -> keys[i] = separator;
+    parent -> children[i + 1] = right;
+    parent -> numKeys++;
+} // end splitChild
+
+// deleteNodes frees the children of an inner node before the node itself.
+// The recursion is only as deep as the tree
+void deleteNodes (BPlusNode * node)
+{
+    if (!node -> leaf)
+        for (int i = 0; i <= node -> numKeys; i++) deleteNodes(node -> children[i]);
+    free(node);
+} // end deleteNodes
+
+// allocateScratch allocates the memory or exits if there is none
+void * allocateScratch (size_t size)
+{
+    void * scratch = malloc(size);
+    if (scratch == NULL) {
+        printf ("Unable to allocate memory to load a B+tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    return scratch;
+} // end allocateScratch
@@ -0,0 +1,88 @@
+#ifndef BPLUSTREE_H_INCLUDED
+#define BPLUSTREE_H_INCLUDED
+
+// A BPlusTree is an ordered map from integer keys to counts that stays
+// shallow however many keys it holds.  Each node holds up to BPLUSFANOUT
+// keys in sorted order.  The counts are all kept in the leaves, which are
+// all at the same depth and are linked together in key order, so a range
+// of keys is read by finding the first one and then walking along the
+// leaves.  The nodes above the leaves only hold keys that guide a search:
+// child i of a node holds the keys from keys[i-1] up to (but not including)
+// keys[i].
+//
+// Finding a key reads one node per level, and with 64 keys to a node a
+// tree of tens of millions of keys is only 4 or 5 levels deep.  The keys of
+// a node are next to each other in memory, so searching a node reads a few
+// neighbouring cache lines rather than following a pointer per key.
+
+// bool is defined in stdbool.h
+#include <stdbool.h>
+
+// BPLUSFANOUT is the most keys a node holds.  64 int keys fill four 64 byte
+// cache lines; a larger value (such as 1024, for a 4096 byte page of keys)
+// makes the tree shallower at the cost of longer searches within a node.
+// It can be set when compiling, for example with -DBPLUSFANOUT=256
+#ifndef BPLUSFANOUT
+#define BPLUSFANOUT 64
+#endif
+
+// BPlusNode struct is a node of the tree.  It has numKeys keys in keys[].
+// A leaf has the count of each key in counts[] and a link to the next leaf
+// in key order (NULL for the last leaf), while a node above the leaves
+// has numKeys+1 children.  The union and the struct in it have no names
+// of their own, so their fields are used as the node's own; that needs C11,
+// so compile with -std=c11 (as the rest of this program already must be)
+typedef struct bPlusNode {
+    int numKeys;
+    bool leaf;
+    int keys[BPLUSFANOUT];
+    union {
+        struct bPlusNode *children[BPLUSFANOUT + 1];
+        struct {
+            int counts[BPLUSFANOUT];
+            struct bPlusNode *next;
+        };
+    };
+} BPlusNode;
+
+// BPlusTreeInfo struct holds the root node, the number of levels of nodes,
+// the number of nodes and the number of keys in the tree
+typedef struct {
+    BPlusNode *root;
+    int height;
+    long numNodes;
+    long numKeys;
+} BPlusTreeInfo, *BPlusTree;
+
+// A BPlusCursor is a position in the tree: index is a key in leaf
+// (leaf is NULL once the cursor has passed the last key)
+typedef struct {
+    BPlusNode *leaf;
+    int index;
+} BPlusCursor;
+
+// initBPlusTree allocates an empty tree
+BPlusTree   initBPlusTree    (void);
+// bulkLoadBPlusTree builds a tree holding n keys, which must be in
+// increasing order with no repeats, and their counts.  It is much faster
+// than inserting the keys one at a time and leaves every node at least
+// half full
+BPlusTree   bulkLoadBPlusTree (int keys[], int counts[], int n);
+// bPlusFind returns the address of the key's count, or NULL if the key is
+// not in the tree
+int *       bPlusFind        (BPlusTree tree, int key);
+// bPlusFindOrInsert returns the address of the key's count, first adding
+// the key with a count of 0 if it is not in the tree.  The address is only
+// good until the next key is added
+int *       bPlusFindOrInsert (BPlusTree tree, int key);
+// bPlusSeek sets the cursor at the first key not less than key
+void        bPlusSeek        (BPlusTree tree, int key, BPlusCursor * cursor);
+// bPlusNext gives the key and count at the cursor and moves the cursor to
+// the next key.  It returns false (and gives nothing) once there are no
+// more keys
+bool        bPlusNext        (BPlusCursor * cursor, int * key, int * count);
+// deleteBPlusTree frees every node and the tree. It returns NULL to show
+// the tree no longer exists
+BPlusTree   deleteBPlusTree  (BPlusTree tree);
+
+#endif // BPLUSTREE_H_INCLUDED
@@ -0,0 +1,183 @@
+// IntCounter.c counts integer keys in an open addressing hash table and
+// hands them back sorted by key.
+//
+// Keys are hashed by multiplying by a large odd constant (Fibonacci
+// hashing) and folding the high bits down, which spreads runs of nearby
+// integers across the table. The sort is a least significant digit radix
+// sort on the keys' bytes, so it takes four passes over the distinct keys
+// no matter how many there are, and a pass is skipped when every key has
+// the same byte in that position.
+
+// printf provides the error message when memory runs out
+#include <stdio.h>
+// stdlib provides malloc(), free() and exit()
+#include <stdlib.h>
+// the counter's own declarations are included for consistency checking
+#include "IntCounter.h"
+
+// MINCOUNTERSLOTS is the fewest slots a counter starts with
+#define MINCOUNTERSLOTS 16
+// RADIXBITS is how many bits of the key each pass of the radix sort uses,
+// and RADIXBUCKETS is how many different values that many bits can hold
+#define RADIXBITS 8
+#define RADIXBUCKETS (1 << RADIXBITS)
+
+// To make sure we are allocating and deallocating dynamic memory,
+// AllocationCount (defined with main) is updated for every allocation
+extern int AllocationCount;
+
+// newSlots is a local function that allocates capacity empty slots
+static IntCount * newSlots (int capacity);
+// slotFor is a local function that returns the slot holding key, or the
+// empty slot where it belongs
+static IntCount * slotFor (IntCounter counter, int key);
+// growCounter is a local function that doubles the number of slots and
+// puts every key back in its new slot
+static void growCounter (IntCounter counter);
+// sortKey is a local function that turns a key into an unsigned value
+// whose order is the same as the key's, so the radix sort can treat the
+// negative keys as smaller than the positive ones
+static unsigned int sortKey (int key);
+
+// initIntCounter allocates the counter with at least twice as many slots as
+// expectedKeys, so that many keys fit without growing
+IntCounter initIntCounter (int expectedKeys)
+{
+    IntCounter counter = (IntCounter) malloc(sizeof(IntCounterInfo));
+    if (counter == NULL) {
+        printf ("Unable to create an integer counter... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    int capacity = MINCOUNTERSLOTS;
+    while (capacity / 2 < expectedKeys) capacity *= 2;
+    counter -> slots = newSlots(capacity);
+    counter -> capacity = capacity;
+    counter -> size = 0;
+    return counter;
+} // end initIntCounter
+
+// countInt finds the key's slot, claiming it if the key is new, and adds
+// one to its count. The table is grown first if it is half full
+void countInt (IntCounter counter, int key)
+{
+    if (2 * (counter -> size + 1) > counter -> capacity) growCounter(counter);
+    IntCount * slot = slotFor(counter, key);
+    if (slot -> count == 0) {
+        slot -> key = key;
+        counter -> size++;
+    }
+    slot -> count++;
+} // end countInt
+
+// intCounterSize returns the number of slots in use
+int intCounterSize (IntCounter counter)
+{
+    return counter -> size;
+} // end intCounterSize
+
+// sortedIntCounts gathers the used slots into out[] and radix sorts them,
+// moving entries back and forth between out[] and a scratch array one byte
+// of the key at a time, starting with the lowest byte. Each pass counts
+// how many keys have each byte value, turns the counts into the position
+// the first key with each value goes to and then moves the keys over in
+// order, so keys with the same byte keep the order the last pass gave them
+int sortedIntCounts (IntCounter counter, IntCount out[])
+{
+    int n = 0;
+    for (int i = 0; i < counter -> capacity; i++)
+        if (counter -> slots[i].count != 0) out[n++] = counter -> slots[i];
+    if (n < 2) return n;
+
+    IntCount * scratch = (IntCount *) malloc(n * sizeof(IntCount));
+    if (scratch == NULL) {
+        printf ("Unable to allocate memory to sort the counts... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+
+    IntCount * from = out;
+    IntCount * to = scratch;
+    for (int shift = 0; shift < 32; shift += RADIXBITS) {
+        int position[RADIXBUCKETS] = {0};
+        for (int i = 0; i < n; i++)
+            position[(sortKey(from[i].key) >> shift) & (RADIXBUCKETS - 1)]++;
+        // every key has the same byte here, so this pass would not move anything
+        if (position[(sortKey(from[0].key) >> shift) & (RADIXBUCKETS - 1)] == n) continue;
+        int total = 0;
+        for (int b = 0; b < RADIXBUCKETS; b++) {
+            int count = position[b];
+            position[b] = total;
+            total += count;
+        }
+        for (int i = 0; i < n; i++)
+            to[position[(sortKey(from[i].key) >> shift) & (RADIXBUCKETS - 1)]++] = from[i];
+        IntCount * swap = from;
+        from = to;
+        to = swap;
+    }
+    // an odd number of passes leaves the sorted keys in the scratch array
+    if (from != out)
+        for (int i = 0; i < n; i++) out[i] = from[i];
+
+    free(scratch);
+    AllocationCount--;
+    return n;
+} // end sortedIntCounts
+
+// deleteIntCounter frees the slots and then the counter
+IntCounter deleteIntCounter (IntCounter counter)
+{
+    free(counter -> slots);
+    AllocationCount--;
+    free(counter);
+    AllocationCount--;
+    return NULL;
+} // end deleteIntCounter
+
+// newSlots allocates the slots with calloc() so every count starts at 0,
+// marking the slot empty
+IntCount * newSlots (int capacity)
+{
+    IntCount * slots = (IntCount *) calloc(capacity, sizeof(IntCount));
+    if (slots == NULL) {
+        printf ("Unable to allocate memory for the integer counter... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    return slots;
+} // end newSlots
+
+// slotFor starts at the key's hashed slot and steps forward (wrapping
+// around at the end) until it finds the key or an empty slot. The table is
+// never more than half full, so an empty slot is always found
+IntCount * slotFor (IntCounter counter, int key)
+{
+    unsigned int hash = (unsigned int) key * 2654435769u;
+    int mask = counter -> capacity - 1;
+    int i = (int) ((hash ^ (hash >> 16)) & (unsigned int) mask);
+    while ((counter -> slots[i].count != 0) && (counter -> slots[i].key != key))
+        i = (i + 1) & mask;
+    return &counter -> slots[i];
+} // end slotFor
+
+// growCounter swaps in a table twice the size and moves each used slot of
+// the old table into the new one
+void growCounter (IntCounter counter)
+{
+    IntCount * old = counter -> slots;
+    int oldCapacity = counter -> capacity;
+    counter -> capacity = 2 * oldCapacity;
+    counter -> slots = newSlots(counter -> capacity);
+    for (int i = 0; i < oldCapacity; i++)
+        if (old[i].count != 0) *slotFor(counter, old[i].key) = old[i];
+    free(old);
+    AllocationCount--;
+} // end growCounter
+
+// sortKey flips the sign bit, which moves the negative keys below the
+// positive ones when the bits are read as an unsigned value
+unsigned int sortKey (int key)
+{
+    return (unsigned int) key ^ 0x80000000u;
+} // end sortKey
@@ -0,0 +1,44 @@
+#ifndef INTCOUNTER_H_INCLUDED
+#define INTCOUNTER_H_INCLUDED
+
+// An IntCounter counts how many times each integer occurs using a hash
+// table with open addressing: every key lives directly in the table's
+// array of slots, and a key whose slot is taken goes in the next free slot
+// after it (linear probing). Counting a key is then a hash and usually one
+// or two neighbouring slots, with no allocation per key.
+// Once counting is done the distinct keys can be taken out in increasing
+// order, sorted with a radix sort, to write the same listing an in-order
+// walk of a BST of the keys would.
+
+// IntCount struct holds one distinct key and the number of times it was
+// counted. A slot with a count of 0 is empty
+typedef struct {
+    int key;
+    int count;
+} IntCount;
+
+// IntCounterInfo struct holds the slots, how many there are (always a
+// power of 2) and how many distinct keys are in use. The table grows
+// once it is half full, keeping probe sequences short
+typedef struct {
+    IntCount *slots;
+    int capacity;
+    int size;
+} IntCounterInfo, *IntCounter;
+
+// initIntCounter allocates an empty counter with room for about
+// expectedKeys distinct keys before it has to grow
+IntCounter  initIntCounter   (int expectedKeys);
+// countInt adds one to the count of key
+void        countInt         (IntCounter counter, int key);
+// intCounterSize returns the number of distinct keys counted
+int         intCounterSize   (IntCounter counter);
+// sortedIntCounts copies every distinct key and its count into out[],
+// which must hold intCounterSize() entries, in increasing order of key.
+// It returns the number of entries copied
+int         sortedIntCounts  (IntCounter counter, IntCount out[]);
+// deleteIntCounter frees the counter. It returns NULL to show the counter
+// no longer exists
+IntCounter  deleteIntCounter (IntCounter counter);
+
+#endif // INTCOUNTER_H_INCLUDED
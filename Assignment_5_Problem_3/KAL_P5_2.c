@@ -10,6 +10,68 @@
 // The traversal done is an in-order.  When done against a BST, it will execute
 // visits in a sorted manner!  That's why the file produced has the integers in
 // increasing order.
+//
+// The BST is kept balanced as an AVL tree: each node records its height and,
+// after an insert, any node whose two subtrees differ in height by more than
+// one is fixed with one or two rotations.  So even a file of integers in sorted
+// order builds a tree of O(log n) height instead of a linked list, and every
+// insert (and the depth of the recursion in inOrder and deleteTree) is O(log n).
+// Each node also records how many nodes and how many occurrences (the total
+// of the frequencies) its subtree holds.  With these, questions such as how
+// many integers are below x, which is the k-th smallest integer or which
+// integer is the median are answered by one walk down the tree.
+//
+// Once counting is done, the frequencies say how often each integer will
+// be looked for if lookups follow the file.  The tree can then be reshaped
+// so that the expected number of comparisons per lookup is as small as
+// possible (frequent integers near the root), which a balanced tree is not.
+// This is exact, by Knuth's dynamic programming method, for up to
+// OPTIMALDPLIMIT integers, and close to it, by Mehlhorn's method of
+// splitting the total frequency in half at each node, for more.
+//
+// A tree can also be built all at once from integers already in sorted
+// order, taking the middle one as the root and building each half the same
+// way.  This takes O(n) time, where inserting them one at a time takes
+// O(n log n), and gives a tree as low as any can be.  An existing tree (for
+// example an optimized one) is put back into that shape by listing its
+// nodes in order and relinking them the same way.
+//
+// For large files the integers can instead be counted in a hash table (see
+// FREQMODE below).  The distinct integers are then sorted once and written
+// out, giving exactly the same file as the in-order traversal of the BST.
+// Or they can be counted in a B+tree, which holds many integers to a node
+// and so stays only a few levels deep, and whose linked leaves give the
+// integers in order for the output file or for any range of integers.
+// Or they can be counted in a splay tree, which moves each integer it
+// counts to its root, so that when a few integers make up most of the file
+// they are found after only a comparison or two.  SPLAYMODE also times the
+// BST and the splay tree counting generated integers that are uniformly
+// spread, sorted, or Zipf distributed.
+//
+// The file can also be read and counted by several threads at once.  It is
+// read into memory in one go and cut, between integers, into INGESTCHUNKS
+// chunks.  The threads of a WorkStealingPool parse the chunks and count
+// each chunk's integers in a BST of its own.  Each of those trees lists its
+// integers in sorted order, the lists are merged (adding the frequencies of
+// an integer found in more than one chunk) and the BST is built at once
+// from the merged list.  It holds exactly what counting the file one
+// integer at a time would, so everything after that, including the output
+// file, is the same.
+//
+// A large BST is written out (and can be summed or updated) by several threads
+// at once.  The top of the tree is cut into pieces, each either one node or a
+// whole subtree no taller than PARALLELCUTOFFHEIGHT, listed in in-order.  The
+// pieces are shared out among the threads of a WorkStealingPool and the
+// results are put back together in the order of the list, so the output is
+// the same as a single thread's.  The pool uses POSIX threads and C11
+// atomics, so compile with -std=c11 and link with -pthread.
+//
+// Once counting is done the tree is only read, so it can be frozen: its
+// NodeData are copied into one array in the order a breadth-first walk of a
+// complete tree would visit them (the Eytzinger layout), where the children
+// of entry k are entries 2k and 2k+1.  A lookup then needs no pointers, the
+// top levels of every search share the same few cache lines, and the entries
+// a search may need a few levels further down can be fetched ahead of time.
 
 
 // stdio provides access to file processing and console processing
@@ -26,18 +88,104 @@
 // it is used whenever a boolean is being produced, used, or passed back to a caller
 #include <stdbool.h>
 
+// the tree's nodes are allocated from a NodeArena
+#include "NodeArena.h"
+// in HASHMODE the integers are counted by an IntCounter
+#include "IntCounter.h"
+// in BPLUSMODE the integers are counted by a BPlusTree
+#include "BPlusTree.h"
+// in SPLAYMODE the integers are counted by a SplayTree
+#include "SplayTree.h"
+// clock() and clock_t, used to time the trees, are defined in time.h
+#include <time.h>
+// INT_MIN, the smallest int, is defined in limits.h
+#include <limits.h>
+// the tree is written out by the worker threads of a WorkStealingPool
+#include "WorkStealingPool.h"
+
 // this is a string constant that sets the name of the file to open and read in
 // integers from
 #define INFILENAME "integers.in"
 // this is a string constant that sets the name of the file to open and write in
 // integers
 #define OUTFILENAME "integersFreq.out"
+// this is an int constant that sets how many tree nodes each slab of the
+// node arena holds
+#define NODESPERSLAB 1024
+
+// FREQMODE chooses how the integers are counted.  In BSTMODE each integer
+// is found or inserted in the BST.  In HASHMODE each integer is counted in
+// a hash table and the distinct integers are sorted once at the end, which
+// is much faster when there are many integers.  In BPLUSMODE each integer
+// is found or inserted in a B+tree, and in SPLAYMODE in a splay tree.  In
+// PARALLELMODE the file is counted by several threads and the counts are
+// merged into the BST.  It can be set when compiling, for example with
+// -DFREQMODE=HASHMODE
+#define BSTMODE 0
+#define HASHMODE 1
+#define BPLUSMODE 2
+#define SPLAYMODE 3
+#define PARALLELMODE 4
+#ifndef FREQMODE
+#define FREQMODE BSTMODE
+#endif
+// this is an int constant that sets how many distinct integers the hash
+// table starts with room for
+#define EXPECTEDINTEGERS 1024
+// this is an int constant that sets how many worker threads share the work
+// of a parallel traversal
+#define TREEPOOLWORKERS 4
+// this is an int constant that sets how many chunks PARALLELMODE cuts the
+// file into.  Having a few for each thread lets a thread that finishes
+// early take another
+#define INGESTCHUNKS 16
+// this is an int constant that sets the height of the tallest subtree that
+// is handled by one thread as a whole.  An AVL subtree this tall holds from
+// a few hundred to a few thousand nodes
+#define PARALLELCUTOFFHEIGHT 12
+// this is an int constant that sets the most different integers for which
+// the exactly optimal tree is worked out.  That takes time and memory
+// growing with the square of their number, so more use the faster method
+#define OPTIMALDPLIMIT 1024
+// these are int constants that set the range of integers BPLUSMODE counts
+// the occurrences of after writing the output file
+#define RANGELOW 0
+#define RANGEHIGH 99
+// these are int constants that set how many integers the trees count when
+// SPLAYMODE times them, how many different integers there are to choose
+// from, and the seed of the random numbers, so every run counts the same
+// integers
+#define BENCHINTEGERS 1000000
+#define BENCHKEYS 65536
+#define BENCHSEED 1
+// this is an int constant that scatters the Zipf distributed integers, so
+// the most frequent ones are not also the smallest.  Being odd, it gives
+// each rank a different integer below BENCHKEYS
+#define ZIPFSCATTER 40503
+// this is an int constant that sets how far ahead a lookup in a frozen tree
+// fetches entries.  Entry k's descendants 3 levels down are the 8 entries
+// from 8k on, which (NodeData being 8 bytes) fill one 64 byte cache line
+#define FROZENLOOKAHEAD 8
+
+// PREFETCH asks the processor to start loading the memory at an address
+// into its cache.  It is only a hint, so other compilers just leave it out
+#ifdef __GNUC__
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address)
+#endif
 
 // To make sure we are allocating and deallocating dynamic memory,
 // variable AllocationCount is declared and referenced by any other
 // code that does dynamic memory allocation and deallocation
 int AllocationCount = 0;
 
+// NodesVisited and FrequencyVisited are totalled by countVisit as
+// parallelMap's threads visit the nodes.  Several threads add to them at
+// once, so they are atomic (atomic_long comes from stdatomic.h, included
+// by WorkStealingPool.h)
+atomic_long NodesVisited, FrequencyVisited;
+
 // NodeData struct contains two integer elements, one
 // called num to allow for a node's number value to be set
 // and the other called freq to count how many times it is
@@ -53,9 +201,20 @@ typedef struct {
 // value and a struct of its own type called treeNode
 // to allow for pointers to adjacent nodes such
 // as parent and left/right subtrees
+// height is the number of nodes on the longest path from
+// this node down to a leaf (a leaf has height 1), which
+// is what keeps the tree balanced
+// size is the number of nodes in the subtree below (and
+// including) this node, and weight is the total of their
+// frequencies
+// parent points back up to the node this one hangs from
+// (NULL for the root)
 typedef struct treeNode {
     NodeData data;
-    struct treeNode *left, *right;
+    struct treeNode *left, *right, *parent;
+    int height;
+    int size;
+    long weight;
 } TreeNode, *TreeNodePtr;
 
 // BinaryTree struct contains one TreeNode struct
@@ -63,16 +222,96 @@ typedef struct treeNode {
 // The TreeNode struct is important as it will be
 // the binary tree's root node and is referenced as
 // -> root
+// It also contains the NodeArena that all of the tree's
+// nodes are allocated from, referenced as -> nodes
 typedef struct {
     TreeNodePtr root;
+    NodeArena nodes;
 } BinaryTree;
 
+// TreePiece struct is one piece of a tree cut up for a parallel traversal.
+// If whole is true it is the entire subtree below node, otherwise it is just
+// the node itself
+typedef struct {
+    TreeNodePtr node;
+    bool whole;
+} TreePiece;
+
+// NodeValue is any function that, when called with a node, returns a value
+// for it to be combined by parallelReduce (such as its frequency)
+typedef long NodeValue (TreeNodePtr node);
+// NodeCombine is any function that combines two values into one (such as
+// adding them).  parallelReduce always combines values in in-order, so the
+// function does not have to be commutative
+typedef long NodeCombine (long first, long second);
+// NodeAction is any function that, when called with a node, does something
+// to it.  parallelMap may call it for different nodes at the same time
+typedef void NodeAction (TreeNodePtr node);
+
+// TextBuffer struct holds text written by one thread: capacity bytes
+// allocated at text, of which length are in use
+typedef struct {
+    char *text;
+    int length;
+    int capacity;
+} TextBuffer;
+
+// ReduceJob, MapJob and WriteJob structs hold what the threads working on
+// the pieces of a parallel reduce, map or write need to know: the pieces,
+// the user's functions and where each piece's result goes
+typedef struct {
+    TreePiece *pieces;
+    NodeValue *value;
+    NodeCombine *combine;
+    long identity;
+    long *results;
+} ReduceJob;
+
+typedef struct {
+    TreePiece *pieces;
+    NodeAction *action;
+} MapJob;
+
+typedef struct {
+    TreePiece *pieces;
+    TextBuffer *texts;
+} WriteJob;
+
+// IngestChunk struct holds what a thread counting one chunk of the file
+// needs: the chunk's text from start up to (not including) end, room for
+// the integers parsed from it and how many there are, the tree counting
+// them and room for the tree's NodeData in sorted order, and how many of
+// those there are.  stopped is true if the chunk holds something that is
+// not an integer, where getInt would have stopped reading the file
+typedef struct {
+    const char *start, *end;
+    int *integers;
+    int count;
+    bool stopped;
+    BinaryTree tree;
+    NodeData *sorted;
+    int distinct;
+} IngestChunk;
+
+// StreamKind says how the integers SPLAYMODE times the trees with are made:
+// uniformly spread over the BENCHKEYS integers, the same integers in sorted
+// order, or with the integer of rank r occurring in proportion to 1/r
+typedef enum {UNIFORMSTREAM, SORTEDSTREAM, ZIPFSTREAM} StreamKind;
+
+// FrozenTreeInfo struct holds a frozen copy of a BST: count NodeData in
+// the Eytzinger layout in entries 1 to count of nodes (entry 0 is not used,
+// so that the children of entry k are simply 2k and 2k+1)
+typedef struct {
+    NodeData *nodes;
+    int count;
+} FrozenTreeInfo, *FrozenTree;
+
 // getInt is a utility that reads integers from a file
 bool        getInt     (FILE *, int *aNum );
 
-// newTreeNode dynamically allocated a tree node, fills
+// newTreeNode allocates a tree node from the node arena, fills
 // in the user data and clears the left and right side links
-TreeNodePtr newTreeNode (NodeData nodeInformation);
+TreeNodePtr newTreeNode (NodeArena nodes, NodeData nodeInformation);
 
 // newNodeData is a utility that packages an integer and a frequency
 // into a user data struct called NodeData
@@ -81,27 +320,222 @@ NodeData    newNodeData (int aNum, int frequency);
 // findOrInsert traverses a binary search tree looking for a node
 // that matches the user criteria.  In this case, it is an integer.
 // It either returns the pointer to the matching node
-// or it links the node into the tree at its proper, sorted location
-TreeNodePtr findOrInsert(BinaryTree, NodeData nodeInformation);
+// or it links the node into the tree at its proper, sorted location,
+// rebalancing the tree (which may change its root) on the way back up.
+// The frequency in nodeInformation is added to the node's frequency
+TreeNodePtr findOrInsert(BinaryTree *, NodeData nodeInformation);
+
+// insertBalanced does the work of findOrInsert for one subtree and
+// returns the subtree's root once it has been rebalanced.  The matching
+// or new node is passed back through found
+TreeNodePtr insertBalanced (NodeArena nodes, TreeNodePtr node, NodeData nodeInformation, TreeNodePtr * found);
+
+// height returns the height of a subtree, 0 if it is empty
+int         height      (TreeNodePtr node);
+
+// subtreeSize and subtreeWeight return the number of nodes and the total
+// of the frequencies of a subtree, 0 if it is empty
+int         subtreeSize (TreeNodePtr node);
+long        subtreeWeight (TreeNodePtr node);
+
+// updateNode sets a node's height, size and weight from its subtrees
+void        updateNode  (TreeNodePtr node);
+
+// rotateLeft and rotateRight turn a subtree so that its right (or left)
+// child becomes its root, and return the new root
+TreeNodePtr rotateLeft  (TreeNodePtr node);
+TreeNodePtr rotateRight (TreeNodePtr node);
+
+// rebalance restores the AVL balance of a node whose subtrees differ in
+// height by up to two, and returns the root of the rebalanced subtree
+TreeNodePtr rebalance   (TreeNodePtr node);
+
+// rankOf returns how many different integers in the tree are less than
+// aNum, and frequencyBelow how many times integers less than aNum occurred
+int         rankOf      (TreeNodePtr root, int aNum);
+long        frequencyBelow (TreeNodePtr root, int aNum);
+
+// selectNode returns the node with the k-th smallest integer, counting
+// from 0, or NULL if the tree has k or fewer nodes
+TreeNodePtr selectNode  (TreeNodePtr root, int k);
+
+// percentileNode returns the node with the smallest integer that at least
+// percent percent of the occurrences are not greater than (so 50 gives the
+// median), or NULL if the tree is empty
+TreeNodePtr percentileNode (TreeNodePtr root, double percent);
 
 // inOrder does a traversal of the BST that will write a file
 // with the traversal results.
 void        inOrder     (FILE *, TreeNodePtr);
 
-// deleteTree() deletes the frees the storage that was allocated by the call
-// to buildTree()
-void deleteTree(TreeNodePtr nodeParent);
+// deleteTree() frees all of the tree's nodes at once by deleting its node
+// arena. If verbose is not 0, it first lists the nodes being freed.
+void deleteTree(BinaryTree * bt, int verbose);
+
+// printFreedNodes lists the nodes of a tree in post-order as they
+// are about to be freed by deleteTree()
+void        printFreedNodes (TreeNodePtr);
+
+// treePieces cuts a tree into the pieces a parallel traversal shares out.
+// It returns a dynamically allocated array of the pieces in in-order and
+// sets count to the number of pieces
+TreePiece * treePieces  (TreeNodePtr root, int * count);
+
+// splitTree adds the pieces of the subtree below node to pieces[] (or, if
+// pieces is NULL, just counts them) starting at index n, and returns the
+// index after the last piece
+int         splitTree   (TreeNodePtr node, TreePiece pieces[], int n);
+
+// parallelReduce uses the pool's threads to combine the values of every
+// node of a tree in in-order, starting from identity.  For example, with a
+// node's frequency as its value and adding as the combination it returns
+// the total of the frequencies
+long        parallelReduce (WorkStealingPool pool, TreeNodePtr root, NodeValue * value,
+                            NodeCombine * combine, long identity);
+
+// parallelMap uses the pool's threads to call action on every node of a tree
+void        parallelMap (WorkStealingPool pool, TreeNodePtr root, NodeAction * action);
+
+// parallelWrite uses the pool's threads to write the same text to the file
+// as inOrder, in the same order
+void        parallelWrite (WorkStealingPool pool, FILE * out, TreeNodePtr root);
+
+// reduceSubtree, mapSubtree and writeSubtree do the work of a parallel
+// reduce, map or write for one whole subtree, using recursion
+long        reduceSubtree (TreeNodePtr node, NodeValue * value, NodeCombine * combine, long identity);
+void        mapSubtree  (TreeNodePtr node, NodeAction * action);
+void        writeSubtree (TextBuffer * buffer, TreeNodePtr node);
+
+// reduceRange, mapRange and writeRange are the bodies of the parallel for
+// loops that work through the pieces, each taking the job and a range of
+// pieces to do
+void        reduceRange (void * job, int first, int last);
+void        mapRange    (void * job, int first, int last);
+void        writeRange  (void * job, int first, int last);
+
+// nodeFrequency returns a node's frequency, nodeOne returns 1 for any node
+// and addValues adds two values.  They are used with parallelReduce to
+// total the frequencies and count the nodes
+long        nodeFrequency (TreeNodePtr node);
+long        nodeOne     (TreeNodePtr node);
+long        addValues   (long first, long second);
+
+// countVisit adds one to NodesVisited and the node's frequency to
+// FrequencyVisited.  It is used with parallelMap to check that every node
+// is visited exactly once
+void        countVisit  (TreeNodePtr node);
+
+// freezeTree copies a BST into a new frozen tree and returns it
+FrozenTree  freezeTree  (TreeNodePtr root);
+
+// collectInOrder copies the NodeData of a subtree in in-order into
+// sorted[] starting at index n and returns the index after the last one
+int         collectInOrder (TreeNodePtr node, NodeData sorted[], int n);
+
+// placeEytzinger copies sorted[] starting at index *next into the frozen
+// tree's entries below entry k, in in-order, moving *next past them
+void        placeEytzinger (FrozenTree frozen, NodeData sorted[], int * next, int k);
+
+// frozenFind returns the frozen tree's entry holding the integer, or NULL
+// if the integer is not there
+NodeData *  frozenFind  (FrozenTree frozen, int aNum);
+
+// frozenFirst and frozenNext step through the entries of a frozen tree in
+// in-order: frozenFirst returns the index of the entry with the smallest
+// integer and frozenNext the index of the entry after entry k.  Both return
+// 0 when there are no more entries
+int         frozenFirst (FrozenTree frozen);
+int         frozenNext  (FrozenTree frozen, int k);
+
+// deleteFrozenTree frees a frozen tree and returns NULL
+FrozenTree  deleteFrozenTree (FrozenTree frozen);
+
+// optimizeTree reshapes a tree so that the expected number of comparisons
+// to find an integer, if each is looked for as often as its frequency, is
+// as small as possible (or, for large trees, nearly so).  The tree keeps
+// its nodes, but is no longer kept height balanced until rebalanceTree
+// is called
+void        optimizeTree (BinaryTree * bt);
+
+// collectNodes copies pointers to the nodes of a subtree in in-order into
+// nodes[] starting at index n and returns the index after the last one
+int         collectNodes (TreeNodePtr node, TreeNodePtr nodes[], int n);
+
+// linkOptimal links nodes[first] to nodes[last-1] into the subtree the
+// table of best roots describes and returns its root.  linkWeightBalanced
+// does the same, choosing roots that split the frequencies in half
+TreeNodePtr linkOptimal (TreeNodePtr nodes[], int best[], int n, int first, int last);
+TreeNodePtr linkWeightBalanced (TreeNodePtr nodes[], long prefix[], int first, int last);
+
+// buildBalancedFromSorted builds a tree of n nodes, taken from the node
+// arena, holding sorted[0] to sorted[n-1], which must be in increasing
+// order of their integers.  The tree is as low as possible, so it is also
+// an AVL tree that findOrInsert can go on adding to.  It returns the root
+TreeNodePtr buildBalancedFromSorted (NodeArena nodes, NodeData sorted[], int n);
+
+// buildBalanced builds the subtree holding sorted[first] to sorted[last]
+// and returns its root
+TreeNodePtr buildBalanced (NodeArena nodes, NodeData sorted[], int first, int last);
+
+// rebalanceTree relinks the nodes of a tree into the lowest possible tree
+void        rebalanceTree (BinaryTree * bt);
+
+// linkBalanced links nodes[first] to nodes[last] into the lowest possible
+// subtree and returns its root
+TreeNodePtr linkBalanced (TreeNodePtr nodes[], int first, int last);
+
+// weightedDepth returns the total over the nodes of a subtree of each
+// node's frequency times the comparisons needed to reach it, where the
+// subtree's root takes depth comparisons
+long        weightedDepth (TreeNodePtr node, int depth);
+
+// hashFrequencies counts the integers of the input file in a hash table
+// and writes them and their occurrences to the output file in the same
+// form as the BST's in-order traversal
+void        hashFrequencies (FILE * in, FILE * out);
+
+// bPlusFrequencies counts the integers of the input file in a B+tree and
+// writes them and their occurrences to the output file in the same form
+// as the BST's in-order traversal
+void        bPlusFrequencies (FILE * in, FILE * out);
+
+// splayFrequencies counts the integers of the input file in a splay tree
+// and writes them and their occurrences to the output file in the same
+// form as the BST's in-order traversal
+void        splayFrequencies (FILE * in, FILE * out);
+
+// benchmarkSplayTree times the BST and the splay tree counting each kind
+// of stream of integers and prints the times
+void        benchmarkSplayTree (void);
+
+// fillStream fills stream[] with n integers of the given kind
+void        fillStream  (int stream[], int n, StreamKind kind);
+
+// parallelCount reads the whole input file and counts its integers into
+// the BST (which must be empty) using the pool's threads
+void        parallelCount (WorkStealingPool pool, FILE * in, BinaryTree * bt);
+
+// parseRange and countRange are the bodies of the parallel for loops that
+// parse the chunks of the file and count each chunk's integers, taking the
+// array of chunks and a range of chunks to do
+void        parseRange  (void * job, int first, int last);
+void        countRange  (void * job, int first, int last);
 
 // main will do the following:
 //      1. It opens both an input and output file.  Failure to be able to
 //          open the files will result in program termination
 //      2. It will build a BST from the file integers and maintain a
 //          count of the number of occurrences of each integer
+//          (or, in HASHMODE, count them in a hash table, in
+//          BPLUSMODE in a B+tree or in SPLAYMODE in a splay tree.
+//          In PARALLELMODE several threads count them)
 //      3. It will write the integers and their occurrences in a file
 int main()
 {
+#if (FREQMODE == BSTMODE) || (FREQMODE == PARALLELMODE)
     // integer is a scratch array used to get complete integers from the file
     int integer;
+#endif
 
     // open the input file and exit if it does not open
     FILE * in = fopen( INFILENAME, "r");
@@ -123,43 +557,143 @@ int main()
     // dynamically allocated
     printf("Allocation count starts at %d\n\n", AllocationCount);
 
+#if FREQMODE == HASHMODE
+    // count the integers with a hash table and write them out in order
+    hashFrequencies(in, out);
+#elif FREQMODE == BPLUSMODE
+    // count the integers with a B+tree and write them out in order
+    bPlusFrequencies(in, out);
+#elif FREQMODE == SPLAYMODE
+    // count the integers with a splay tree and write them out in order,
+    // then see how it compares with the BST
+    splayFrequencies(in, out);
+    benchmarkSplayTree();
+#else
     // both files are open, declare the binary search tree (bst)
-    // and initialize its root as NULL
+    // and initialize its root as NULL and the arena its nodes
+    // will be allocated from
     BinaryTree bst;
     bst.root = NULL;
+    bst.nodes = initNodeArena(sizeof(TreeNode), NODESPERSLAB);
 
     // get integers and insert them into the BST.
-    // since new nodes will have a frequency of 0 and matching
-    // nodes will have a current frequency, bump the frequency
-    // in either case to reflect their occurrence in the text
-    while (getInt(in, &integer) == true) {
-        if (bst.root == NULL)
-            bst.root = newTreeNode(newNodeData(integer, 1));
-        else {
-            TreeNodePtr node = findOrInsert(bst, newNodeData(integer, 0));
-            node -> data.freq++;
-        }
-    }
+    // a frequency of 1 is added to a matching node's current
+    // frequency, or given to a new node, to reflect each
+    // integer's occurrence in the text
+#if FREQMODE == PARALLELMODE
+    // have several threads count the integers and merge their counts
+    // into the tree
+    WorkStealingPool ingestPool = initWorkStealingPool(TREEPOOLWORKERS);
+    parallelCount(ingestPool, in, &bst);
+    ingestPool = deleteWorkStealingPool(ingestPool);
+#else
+    while (getInt(in, &integer) == true)
+        findOrInsert(&bst, newNodeData(integer, 1));
+#endif
     // print and display the number of items currently
     // dynamically allocated after building the tree
     printf("Allocation count after tree build is %d\n\n", AllocationCount);
 
-    // The file has been processed.  Write out the results by using
-    // an in-order traversal and writing as the "visit"
+    // the sizes and weights kept in the nodes find the median, the
+    // 90th percentile and the middle of the different integers, and
+    // how much of the file is below 0, without a traversal
+    if (bst.root != NULL) {
+        printf("The median integer is %d and the 90th percentile is %d\n",
+               percentileNode(bst.root, 50) -> data.num, percentileNode(bst.root, 90) -> data.num);
+        printf("The middle of the %d different integers is %d\n",
+               bst.root -> size, selectNode(bst.root, bst.root -> size / 2) -> data.num);
+        printf("%d different integers occurring %ld times are below 0\n\n",
+               rankOf(bst.root, 0), frequencyBelow(bst.root, 0));
+
+        // reshape the tree so that looking up the integers as often as
+        // they occurred takes as few comparisons as possible
+        printf("Looking up every integer takes %.3f comparisons on average",
+               (double) weightedDepth(bst.root, 1) / bst.root -> weight);
+        optimizeTree(&bst);
+        printf(", %.3f in the optimized tree\n\n",
+               (double) weightedDepth(bst.root, 1) / bst.root -> weight);
+
+        // put the tree back into balanced shape so that it stays low
+        // whatever is looked up or added next
+        printf("The optimized tree has height %d", bst.root -> height);
+        rebalanceTree(&bst);
+        printf(", the rebalanced tree has height %d\n", bst.root -> height);
+
+        // a tree built straight from the integers in sorted order has
+        // the same height without comparing a single integer
+        NodeData * sorted = (NodeData *) malloc(bst.root -> size * sizeof(NodeData));
+        if (sorted == NULL) {
+            printf ("Unable to allocate memory to copy the tree... exiting");
+            exit (0);
+        }
+        AllocationCount++;
+        BinaryTree copy;
+        copy.nodes = initNodeArena(sizeof(TreeNode), NODESPERSLAB);
+        copy.root = buildBalancedFromSorted(copy.nodes, sorted,
+                                            collectInOrder(bst.root, sorted, 0));
+        printf("A tree built from the sorted integers has height %d\n\n", copy.root -> height);
+        deleteTree(&copy, 0);
+        free(sorted);
+        AllocationCount--;
+    }
+
+    // The file has been processed.  Start the threads that share
+    // the work of traversing the tree
+    WorkStealingPool pool = initWorkStealingPool(TREEPOOLWORKERS);
+
+    // total up the integers read and the distinct integers
+    printf("The file held %ld integers, %ld of them different\n\n",
+           parallelReduce(pool, bst.root, nodeFrequency, addValues, 0),
+           parallelReduce(pool, bst.root, nodeOne, addValues, 0));
+
+    // have the threads visit every node, and check the visits add up to
+    // the nodes and occurrences the tree says it holds
+    atomic_store(&NodesVisited, 0);
+    atomic_store(&FrequencyVisited, 0);
+    parallelMap(pool, bst.root, countVisit);
+    if ((atomic_load(&NodesVisited) != subtreeSize(bst.root)) ||
+        (atomic_load(&FrequencyVisited) != subtreeWeight(bst.root))) {
+        printf ("The threads did not visit every node once... exiting");
+        exit (0);
+    }
+    printf("The threads visited all %ld nodes once\n\n", atomic_load(&NodesVisited));
+
+    // Write out the results by using an in-order traversal and
+    // writing as the "visit", with the threads writing different
+    // parts of the tree at the same time
     fprintf(out, "\nIntegers       Frequency\n\n");
-    inOrder(out, bst.root);
+    parallelWrite(pool, out, bst.root);
     fprintf(out, "\n\n");
+    pool = deleteWorkStealingPool(pool);
 
-    // delete the binary tree and free all node memory
-    deleteTree(bst.root);
-    // set the tree to NULL to reflect the binary tree no longer exists
-    bst.root = NULL;
+    // the tree will not change from now on, so freeze it and use the
+    // frozen copy to look up every integer in the file a second time
+    FrozenTree frozen = freezeTree(bst.root);
+    rewind(in);
+    int found = 0, lookups = 0;
+    while (getInt(in, &integer) == true) {
+        lookups++;
+        if (frozenFind(frozen, integer) != NULL) found++;
+    }
+    // and step through it in order to check the frequencies total up
+    long total = 0;
+    for (int k = frozenFirst(frozen); k != 0; k = frozenNext(frozen, k))
+        total += frozen -> nodes[k].freq;
+    printf("The frozen tree of %d integers found %d of %d lookups, frequencies total %ld\n\n",
+           frozen -> count, found, lookups, total);
+    frozen = deleteFrozenTree(frozen);
+
+    // delete the binary tree and free all node memory, listing
+    // the nodes as they go. This also sets the tree to NULL to
+    // reflect the binary tree no longer exists
+    deleteTree(&bst, 1);
     // prove the binary tree does not exist by printing and displaying
     // AllocationCount to equal zero and conduct a final in-order transversal
     // Nothing will print
     printf("\nAllocation count after deleting the tree is %d\n\n", AllocationCount);
     inOrder(out, bst.root);
     printf("Back from inOrder.. nothing should have printed.\n");
+#endif
 
     // close both files and return.  We're done!!
     fclose(in);
@@ -196,69 +730,251 @@ bool getInt(FILE * in, int *aNum)
 // in this implementation, the nodeInformation field "integer" is being
 // looked at to see if there is a match.
 //
+// The search itself is done by insertBalanced, which also adds the node
+// if it is not found and rebalances the tree on the way back up.  Because
+// rebalancing may rotate a different node to the top of the tree, the tree
+// is passed by address so its root can be updated.
+// the node we return will either be a new node or a node that we have
+// found, with nodeInformation's frequency added to it.  That enables the
+// caller to count an occurrence without knowing if this was a new node or
+// a match, and lets the sizes and weights on the way to the node be kept
+// up to date
+//
+TreeNodePtr findOrInsert(BinaryTree * bt, NodeData nodeInformation)
+{
+    // the node that matched or was added
+    TreeNodePtr found;
+    // search (and possibly grow and rebalance) the tree from its root
+    bt -> root = insertBalanced(bt -> nodes, bt -> root, nodeInformation, &found);
+    // the root may have changed, and the root hangs from nothing
+    bt -> root -> parent = NULL;
+    // return pointer to the node
+    return found;
+} //end findOrInsert
+
+// insertBalanced looks for nodeInformation in the subtree whose root is node.
+//
 // Because this is a binary tree, we can keep comparing if the
 // value is less than us (indicating to proceed left), is us, or
 // greater than us (indicating to proceed right).
-// If we hit the end of a left traversal and the value has not been found,
-// we add it to our left side and return it
-// In a similar manner, if we hit the end of a right traversal and the
-// value has not been found, we add it to the right side and return it
-// the node we return will either be a new node (zero frequency) or a node
-// that we have found.  That enables the caller to increment the frequency
-// without knowing if this was a new node or a match
-//
-TreeNodePtr findOrInsert(BinaryTree bt, NodeData nodeInformation)
-{
-    // if the root is empty, just return a node with the nodeInformation in it
-    if (bt.root == NULL) return newTreeNode(nodeInformation);
-
-    // curr is the tree node currently at the top of the tree
-    TreeNodePtr curr = bt.root;
-    // loop until we have a match (returns in the loop will happen if
-    // we hit the end of the tree
-    while (nodeInformation.num != curr -> data.num) {
-        // are we less than the node?
-        if (nodeInformation.num < curr -> data.num) {
-            // yes, need to go left if we can
-            // NULL indicates we are at a left leaf, so add the new node
-            // to the current leaf on the left side and return it
-            if (curr -> left == NULL)
-                return curr -> left = newTreeNode(nodeInformation);
-            else
-                // keep looking left since we are not at a leaf
-                curr = curr -> left;
-        } else {
-            // we are greater than the current right side
-            // need to go further right if we can
-            // NULL indicates we are at a right leaf, so add the new node
-            // to the current leaf on the right side and return it
-            if (curr -> right == NULL)
-                return curr -> right = newTreeNode(nodeInformation);
-            else
-                // keep looking right since we are not at a leaf
-                curr = curr -> right;
+// If we hit an empty subtree the value has not been found, so a new node
+// takes its place.  Only the nodes on the path down to the new node can
+// become unbalanced, so each one is rebalanced as the recursion returns,
+// which also updates its size and weight.
+// The recursion is only as deep as the tree, which is O(log n) nodes
+TreeNodePtr insertBalanced(NodeArena nodes, TreeNodePtr node, NodeData nodeInformation, TreeNodePtr * found)
+{
+    // an empty subtree means the value is not in the tree, so add it here
+    if (node == NULL) return *found = newTreeNode(nodes, nodeInformation);
+
+    if (nodeInformation.num < node -> data.num)
+        // we are less than the node, so look in (and rebuild) the left side
+        node -> left = insertBalanced(nodes, node -> left, nodeInformation, found);
+    else if (nodeInformation.num > node -> data.num)
+        // we are greater than the node, so look in the right side
+        node -> right = insertBalanced(nodes, node -> right, nodeInformation, found);
+    else {
+        // we found a node that matched, so add to its frequency.
+        // nothing below it has changed, but its weight has
+        node -> data.freq += nodeInformation.freq;
+        updateNode(node);
+        *found = node;
+        return node;
+    }
+    // a node may have been added below us, so restore the balance here
+    return rebalance(node);
+} //end insertBalanced
+
+// height returns 0 for an empty subtree and otherwise the height
+// recorded in the subtree's root
+int height(TreeNodePtr node)
+{
+    return (node == NULL) ? 0 : node -> height;
+} //end height
+
+// subtreeSize returns 0 for an empty subtree and otherwise the size
+// recorded in the subtree's root
+int subtreeSize(TreeNodePtr node)
+{
+    return (node == NULL) ? 0 : node -> size;
+} //end subtreeSize
+
+// subtreeWeight returns 0 for an empty subtree and otherwise the weight
+// recorded in the subtree's root
+long subtreeWeight(TreeNodePtr node)
+{
+    return (node == NULL) ? 0 : node -> weight;
+} //end subtreeWeight
+
+// updateNode makes a node one higher than the higher of its subtrees,
+// and adds the node itself to their sizes and weights.  Every change to
+// the tree calls it for each node whose subtree changed, lowest first, so
+// it is also where the children are pointed back up at the node
+void updateNode(TreeNodePtr node)
+{
+    if (node -> left != NULL) node -> left -> parent = node;
+    if (node -> right != NULL) node -> right -> parent = node;
+    int leftHeight = height(node -> left);
+    int rightHeight = height(node -> right);
+    node -> height = 1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight);
+    node -> size = 1 + subtreeSize(node -> left) + subtreeSize(node -> right);
+    node -> weight = node -> data.freq + subtreeWeight(node -> left) + subtreeWeight(node -> right);
+} //end updateNode
+
+// rotateLeft moves the node down to the left of its right child, which
+// takes its place.  The child's left subtree becomes the node's right
+// subtree so the tree stays in sorted order
+TreeNodePtr rotateLeft(TreeNodePtr node)
+{
+    TreeNodePtr child = node -> right;
+    node -> right = child -> left;
+    child -> left = node;
+    // the node is now below the child, so update it first
+    updateNode(node);
+    updateNode(child);
+    return child;
+} //end rotateLeft
+
+// rotateRight is the mirror image of rotateLeft
+TreeNodePtr rotateRight(TreeNodePtr node)
+{
+    TreeNodePtr child = node -> left;
+    node -> left = child -> right;
+    child -> right = node;
+    updateNode(node);
+    updateNode(child);
+    return child;
+} //end rotateRight
+
+// rebalance compares the heights of a node's subtrees.  If the left side
+// is two higher, a right rotation lifts it, after first rotating the left
+// child left if its own right side is the higher one (otherwise the single
+// rotation would just move the imbalance to the other side).  A right side
+// two higher is fixed the same way in mirror image.
+TreeNodePtr rebalance(TreeNodePtr node)
+{
+    updateNode(node);
+    int balance = height(node -> left) - height(node -> right);
+    if (balance > 1) {
+        // left side too high
+        if (height(node -> left -> right) > height(node -> left -> left))
+            node -> left = rotateLeft(node -> left);
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        // right side too high
+        if (height(node -> right -> left) > height(node -> right -> right))
+            node -> right = rotateRight(node -> right);
+        return rotateLeft(node);
+    }
+    // already balanced
+    return node;
+} //end rebalance
+
+// rankOf walks down from the root to where aNum is or would be.  Every
+// time it goes right, the node it leaves and that node's left subtree are
+// all less than aNum, so their count is added on
+int rankOf(TreeNodePtr root, int aNum)
+{
+    int rank = 0;
+    TreeNodePtr curr = root;
+    while (curr != NULL) {
+        if (aNum <= curr -> data.num)
+            curr = curr -> left;
+        else {
+            rank += subtreeSize(curr -> left) + 1;
+            curr = curr -> right;
         }
     }
-    // we get here if the while completed, indicating we found a node
-    // that matched a current node in the tree
-    // return pointer to the node
-    return curr;
-} //end findOrInsert
+    return rank;
+} //end rankOf
 
-// newTreeNode makes a node through dynamic allocation, initializing
+// frequencyBelow walks down as rankOf does, adding up frequencies
+// instead of counting nodes
+long frequencyBelow(TreeNodePtr root, int aNum)
+{
+    long below = 0;
+    TreeNodePtr curr = root;
+    while (curr != NULL) {
+        if (aNum <= curr -> data.num)
+            curr = curr -> left;
+        else {
+            below += subtreeWeight(curr -> left) + curr -> data.freq;
+            curr = curr -> right;
+        }
+    }
+    return below;
+} //end frequencyBelow
+
+// selectNode compares k with the size of the left subtree: if k is
+// smaller the node is in the left subtree, if equal it is this node and
+// otherwise it is in the right subtree, after skipping the left subtree
+// and this node
+TreeNodePtr selectNode(TreeNodePtr root, int k)
+{
+    TreeNodePtr curr = root;
+    while (curr != NULL) {
+        int leftSize = subtreeSize(curr -> left);
+        if (k < leftSize)
+            curr = curr -> left;
+        else if (k == leftSize)
+            return curr;
+        else {
+            k -= leftSize + 1;
+            curr = curr -> right;
+        }
+    }
+    return NULL;
+} //end selectNode
+
+// percentileNode works out how many occurrences, target, must be at or
+// below the node wanted (at least 1 and at most all of them), and then
+// finds the node as selectNode does, with weights in place of sizes:
+// the node wanted is the one whose own occurrences take the count of
+// occurrences so far up to target
+TreeNodePtr percentileNode(TreeNodePtr root, double percent)
+{
+    if (root == NULL) return NULL;
+    long total = root -> weight;
+    // multiplying before dividing keeps whole percentages exact
+    double exact = percent * total / 100.0;
+    long target = (long) exact;
+    if (target < exact) target++;
+    if (target < 1) target = 1;
+    if (target > total) target = total;
+    TreeNodePtr curr = root;
+    while (curr != NULL) {
+        long leftWeight = subtreeWeight(curr -> left);
+        if (target <= leftWeight)
+            curr = curr -> left;
+        else if (target <= leftWeight + curr -> data.freq)
+            return curr;
+        else {
+            target -= leftWeight + curr -> data.freq;
+            curr = curr -> right;
+        }
+    }
+    return NULL;
+} //end percentileNode
+
+// newTreeNode makes a node by taking it from the node arena, initializing
 // its left and right children to NULL and inserting the user data provided
-// as nodeInformation.
+// as nodeInformation. The arena updates AllocationCount whenever it
+// allocates a new slab.
 // It returns the pointer to the tree node it just allocated and initialized
-TreeNodePtr newTreeNode(NodeData nodeInformation)
+TreeNodePtr newTreeNode(NodeArena nodes, NodeData nodeInformation)
 {
-    // allocate a tree node
-    TreeNodePtr p = (TreeNodePtr) malloc(sizeof(TreeNode));
-    // update AllocationCount to reflect the newly created memory
-    AllocationCount++;
+    // allocate a tree node from the arena
+    TreeNodePtr p = (TreeNodePtr) arenaAlloc(nodes);
     // fill in the user data
     p -> data = nodeInformation;
-    // NULL its links
-    p -> left = p -> right = NULL;
+    // NULL its links, which makes it a leaf of height 1 and
+    // size 1, weighing its own frequency.  Its parent is set
+    // when it is linked into a tree
+    p -> left = p -> right = p -> parent = NULL;
+    p -> height = 1;
+    p -> size = 1;
+    p -> weight = p -> data.freq;
     // give it back to the caller
     return p;
 } //end newTreeNode
@@ -281,24 +997,940 @@ void inOrder(FILE * out, TreeNodePtr node)
     return;
 } //end inOrder
 
-// deleteTree() uses recursion to search the tree, delete and free up all of its nodes
+// deleteTree() takes a binary tree and frees all of its nodes by deleting
+// the node arena they came from, which costs one free() per slab rather
+// than one per node and needs no walk of the tree. When verbose is not 0
+// the nodes are listed first, which does walk the tree.
+// The tree's root and arena are set to NULL to reflect that the binary
+// tree no longer exists. It returns nothing
+void deleteTree(BinaryTree * bt, int verbose)
+{
+    // list the nodes in the order they used to be freed one at a time
+    if (verbose) printFreedNodes(bt -> root);
+    // free every node at once
+    bt -> nodes = deleteNodeArena(bt -> nodes);
+    bt -> root = NULL;
+} //end deleteTree
+
+// printFreedNodes() uses recursion to list the nodes of a tree in post-order,
+// as each one is about to be freed
 // It returns nothing
-void deleteTree(TreeNodePtr rootNode)
+void printFreedNodes(TreeNodePtr rootNode)
 {
     // check if binary tree node is not NULL
     if (rootNode != NULL) {
-        // delete node's left subtree
-        deleteTree(rootNode->left);
-        // delete node's right subtree
-        deleteTree(rootNode->right);
-        // display which node will be deleted and freed
-        printf("Node %d has been freed\n", rootNode->data);
-        // delete and free the node
-        free(rootNode);
-        // decrease AllocationCount to reflect the freed memory
+        // list node's left subtree
+        printFreedNodes(rootNode -> left);
+        // list node's right subtree
+        printFreedNodes(rootNode -> right);
+        // display which node will be freed
+        printf("Node %d has been freed\n", rootNode -> data.num);
+    }
+} //end printFreedNodes
+
+// treePieces counts the pieces first, so that the array can be allocated
+// at exactly the right size, and then fills it in
+TreePiece * treePieces(TreeNodePtr root, int * count)
+{
+    *count = splitTree(root, NULL, 0);
+    TreePiece * pieces = (TreePiece *) malloc((*count > 0 ? *count : 1) * sizeof(TreePiece));
+    if (pieces == NULL) {
+        printf ("Unable to allocate memory to split the tree... exiting");
+        exit (0);
+    }
+    AllocationCount++;
+    splitTree(root, pieces, 0);
+    return pieces;
+} //end treePieces
+
+// splitTree makes a subtree no taller than PARALLELCUTOFFHEIGHT one whole
+// piece.  A taller subtree is split the same way as an in-order
+// traversal: the pieces of its left subtree, then its root on its own and
+// then the pieces of its right subtree.  Only the nodes above the cut are
+// visited, so the recursion is only as deep as the tree
+int splitTree(TreeNodePtr node, TreePiece pieces[], int n)
+{
+    // an empty subtree has no pieces
+    if (node == NULL) return n;
+    if (height(node) <= PARALLELCUTOFFHEIGHT) {
+        if (pieces != NULL) {
+            pieces[n].node = node;
+            pieces[n].whole = true;
+        }
+        return n + 1;
+    }
+    n = splitTree(node -> left, pieces, n);
+    if (pieces != NULL) {
+        pieces[n].node = node;
+        pieces[n].whole = false;
+    }
+    n = splitTree(node -> right, pieces, n + 1);
+    return n;
+} //end splitTree
+
+// parallelReduce has the threads reduce each piece to one value, stored
+// in an array with one entry for each piece.  The entries are then
+// combined in order by this thread, so the result is the same however the
+// pieces were shared out
+long parallelReduce(WorkStealingPool pool, TreeNodePtr root, NodeValue * value,
+                    NodeCombine * combine, long identity)
+{
+    int count;
+    ReduceJob job;
+    job.pieces = treePieces(root, &count);
+    job.value = value;
+    job.combine = combine;
+    job.identity = identity;
+    job.results = (long *) malloc((count > 0 ? count : 1) * sizeof(long));
+    if (job.results == NULL) {
+        printf ("Unable to allocate memory to reduce the tree... exiting");
+        exit (0);
+    }
+    AllocationCount++;
+    // one piece at a time, since a whole piece is already a lot of work
+    poolParallelFor(pool, 0, count, 1, reduceRange, &job);
+    long result = identity;
+    for (int i = 0; i < count; i++)
+        result = combine(result, job.results[i]);
+    free(job.results);
+    free(job.pieces);
+    AllocationCount -= 2;
+    return result;
+} //end parallelReduce
+
+// parallelMap has the threads call the action on the nodes of each piece
+void parallelMap(WorkStealingPool pool, TreeNodePtr root, NodeAction * action)
+{
+    int count;
+    MapJob job;
+    job.pieces = treePieces(root, &count);
+    job.action = action;
+    poolParallelFor(pool, 0, count, 1, mapRange, &job);
+    free(job.pieces);
+    AllocationCount--;
+} //end parallelMap
+
+// parallelWrite has the threads write the text of each piece into a buffer
+// of its own.  Once all are done, the buffers (one for each piece, as every
+// piece has at least one node) are counted in AllocationCount by this
+// thread, then written to the file in order and freed
+void parallelWrite(WorkStealingPool pool, FILE * out, TreeNodePtr root)
+{
+    int count;
+    WriteJob job;
+    job.pieces = treePieces(root, &count);
+    job.texts = (TextBuffer *) calloc((count > 0 ? count : 1), sizeof(TextBuffer));
+    if (job.texts == NULL) {
+        printf ("Unable to allocate memory to write the tree... exiting");
+        exit (0);
+    }
+    AllocationCount++;
+    poolParallelFor(pool, 0, count, 1, writeRange, &job);
+    AllocationCount += count;
+    for (int i = 0; i < count; i++) {
+        fwrite(job.texts[i].text, 1, job.texts[i].length, out);
+        free(job.texts[i].text);
+        AllocationCount--;
+    }
+    free(job.texts);
+    free(job.pieces);
+    AllocationCount -= 2;
+} //end parallelWrite
+
+// reduceSubtree combines the values of the left subtree, the node and the
+// right subtree, in that order
+long reduceSubtree(TreeNodePtr node, NodeValue * value, NodeCombine * combine, long identity)
+{
+    if (node == NULL) return identity;
+    long result = reduceSubtree(node -> left, value, combine, identity);
+    result = combine(result, value(node));
+    return combine(result, reduceSubtree(node -> right, value, combine, identity));
+} //end reduceSubtree
+
+// mapSubtree calls the action on each node of a subtree
+void mapSubtree(TreeNodePtr node, NodeAction * action)
+{
+    if (node != NULL) {
+        mapSubtree(node -> left, action);
+        action(node);
+        mapSubtree(node -> right, action);
+    }
+} //end mapSubtree
+
+// writeSubtree does what inOrder does, but adds each line to the end of
+// the buffer instead of writing it to a file.  The buffer is doubled in
+// size whenever a line might not fit.  AllocationCount is left for the
+// caller to update, since several threads updating it at once would lose
+// some of the updates
+void writeSubtree(TextBuffer * buffer, TreeNodePtr node)
+{
+    if (node != NULL) {
+        // go left
+        writeSubtree(buffer, node -> left);
+        // make sure there is room for the longest possible line
+        if (buffer -> length + 32 > buffer -> capacity) {
+            buffer -> capacity = (buffer -> capacity == 0) ? 4096 : 2 * buffer -> capacity;
+            buffer -> text = (char *) realloc(buffer -> text, buffer -> capacity);
+            if (buffer -> text == NULL) {
+                printf ("Unable to allocate memory to write the tree... exiting");
+                exit (0);
+            }
+        }
+        // "visit" by adding the user information
+        buffer -> length += sprintf(buffer -> text + buffer -> length, "%d %2d\n",
+                                    node -> data.num, node -> data.freq);
+        // go right
+        writeSubtree(buffer, node -> right);
+    }
+} //end writeSubtree
+
+// reduceRange reduces each of its pieces, keeping each piece's result in
+// the job's array
+void reduceRange(void * job, int first, int last)
+{
+    ReduceJob * reduce = (ReduceJob *) job;
+    for (int i = first; i < last; i++) {
+        TreePiece piece = reduce -> pieces[i];
+        if (piece.whole)
+            reduce -> results[i] = reduceSubtree(piece.node, reduce -> value,
+                                                 reduce -> combine, reduce -> identity);
+        else
+            reduce -> results[i] = reduce -> value(piece.node);
+    }
+} //end reduceRange
+
+// mapRange calls the action on the nodes of each of its pieces
+void mapRange(void * job, int first, int last)
+{
+    MapJob * map = (MapJob *) job;
+    for (int i = first; i < last; i++) {
+        if (map -> pieces[i].whole) mapSubtree(map -> pieces[i].node, map -> action);
+        else map -> action(map -> pieces[i].node);
+    }
+} //end mapRange
+
+// writeRange writes the text of each of its pieces into the piece's buffer.
+// A single node is written as a subtree with no children would be
+void writeRange(void * job, int first, int last)
+{
+    WriteJob * write = (WriteJob *) job;
+    for (int i = first; i < last; i++) {
+        TreePiece piece = write -> pieces[i];
+        if (piece.whole) writeSubtree(&write -> texts[i], piece.node);
+        else {
+            TreeNode alone = *piece.node;
+            alone.left = alone.right = NULL;
+            writeSubtree(&write -> texts[i], &alone);
+        }
+    }
+} //end writeRange
+
+// nodeFrequency returns the number of times the node's integer was found
+long nodeFrequency(TreeNodePtr node)
+{
+    return node -> data.freq;
+} //end nodeFrequency
+
+// nodeOne counts a node as 1, whatever it holds
+long nodeOne(TreeNodePtr node)
+{
+    (void) node;
+    return 1;
+} //end nodeOne
+
+// addValues adds two values
+long addValues(long first, long second)
+{
+    return first + second;
+} //end addValues
+
+// countVisit adds to the totals with atomic additions, so no addition is
+// lost when two threads add at the same time
+void countVisit(TreeNodePtr node)
+{
+    atomic_fetch_add(&NodesVisited, 1);
+    atomic_fetch_add(&FrequencyVisited, node -> data.freq);
+} //end countVisit
+
+// freezeTree counts the nodes, copies their NodeData into a sorted array
+// with an in-order traversal and then deals the sorted NodeData out to the
+// frozen tree's entries with an in-order traversal of the implicit tree.
+// The sorted array is freed before returning.  Both traversals recurse
+// only as deep as their tree, which is O(log n) for either
+FrozenTree freezeTree(TreeNodePtr root)
+{
+    FrozenTree frozen = (FrozenTree) malloc(sizeof(FrozenTreeInfo));
+    int count = (int) reduceSubtree(root, nodeOne, addValues, 0);
+    NodeData * sorted = (NodeData *) malloc((count + 1) * sizeof(NodeData));
+    if ((frozen == NULL) || (sorted == NULL)) {
+        printf ("Unable to allocate memory to freeze the tree... exiting");
+        exit (0);
+    }
+    frozen -> nodes = (NodeData *) malloc((count + 1) * sizeof(NodeData));
+    if (frozen -> nodes == NULL) {
+        printf ("Unable to allocate memory to freeze the tree... exiting");
+        exit (0);
+    }
+    AllocationCount += 3;
+    frozen -> count = count;
+    collectInOrder(root, sorted, 0);
+    int next = 0;
+    placeEytzinger(frozen, sorted, &next, 1);
+    free(sorted);
+    AllocationCount--;
+    return frozen;
+} //end freezeTree
+
+// collectInOrder is inOrder with copying into the array as the "visit"
+int collectInOrder(TreeNodePtr node, NodeData sorted[], int n)
+{
+    if (node != NULL) {
+        n = collectInOrder(node -> left, sorted, n);
+        sorted[n++] = node -> data;
+        n = collectInOrder(node -> right, sorted, n);
+    }
+    return n;
+} //end collectInOrder
+
+// placeEytzinger walks the implicit tree in in-order, going left to entry
+// 2k and right to entry 2k+1, and fills each entry with the next sorted
+// NodeData.  Entries past count do not exist, so the frozen tree is in
+// sorted order along every search path just as the BST was
+void placeEytzinger(FrozenTree frozen, NodeData sorted[], int * next, int k)
+{
+    if (k <= frozen -> count) {
+        placeEytzinger(frozen, sorted, next, 2 * k);
+        frozen -> nodes[k] = sorted[(*next)++];
+        placeEytzinger(frozen, sorted, next, 2 * k + 1);
+    }
+} //end placeEytzinger
+
+// frozenFind goes down from entry 1, to 2k if the integer is not greater
+// than entry k's and otherwise to 2k+1, until it falls off the bottom of
+// the tree.  The comparison is added to the index rather than tested, so
+// there is no branch for the processor to guess wrong, and the entries
+// FROZENLOOKAHEAD times further on are fetched while the search goes on.
+// The last entry the search went left from holds the smallest integer not
+// less than the one wanted.  Going left added a 0 bit to the index, so
+// that entry is found by dropping the trailing 1 bits (the right turns
+// taken after it) and then one more bit
+NodeData * frozenFind(FrozenTree frozen, int aNum)
+{
+    int k = 1;
+    while (k <= frozen -> count) {
+        PREFETCH(frozen -> nodes + FROZENLOOKAHEAD * k);
+        k = 2 * k + (frozen -> nodes[k].num < aNum);
+    }
+    while (k & 1) k >>= 1;
+    k >>= 1;
+    // k is 0 if every integer in the tree is less than the one wanted
+    if ((k != 0) && (frozen -> nodes[k].num == aNum)) return &frozen -> nodes[k];
+    return NULL;
+} //end frozenFind
+
+// frozenFirst goes left from entry 1 as far as possible
+int frozenFirst(FrozenTree frozen)
+{
+    if (frozen -> count == 0) return 0;
+    int k = 1;
+    while (2 * k <= frozen -> count) k = 2 * k;
+    return k;
+} //end frozenFirst
+
+// frozenNext goes to the leftmost entry of entry k's right subtree, if it
+// has one.  Otherwise it climbs while it is a right child (an odd index)
+// and then once more, to the parent it is the left child of.  Climbing
+// past entry 1 reaches 0, the end of the traversal
+int frozenNext(FrozenTree frozen, int k)
+{
+    if (2 * k + 1 <= frozen -> count) {
+        k = 2 * k + 1;
+        while (2 * k <= frozen -> count) k = 2 * k;
+        return k;
+    }
+    while (k & 1) k >>= 1;
+    return k >> 1;
+} //end frozenNext
+
+// deleteFrozenTree frees the entries and then the frozen tree
+FrozenTree deleteFrozenTree(FrozenTree frozen)
+{
+    free(frozen -> nodes);
+    free(frozen);
+    AllocationCount -= 2;
+    return NULL;
+} //end deleteFrozenTree
+
+// hashFrequencies counts each integer read from the file in an IntCounter.
+// Once the file is processed, the distinct integers are copied out sorted
+// into a dynamically allocated array, which is written to the file the
+// same way inOrder writes each node, so the output file matches BSTMODE's
+void hashFrequencies(FILE * in, FILE * out)
+{
+    // integer is a scratch array used to get complete integers from the file
+    int integer;
+    // the counter starts small and grows as new integers are found
+    IntCounter counter = initIntCounter(EXPECTEDINTEGERS);
+    while (getInt(in, &integer) == true)
+        countInt(counter, integer);
+    // print and display the number of items currently
+    // dynamically allocated after counting
+    printf("Allocation count after counting is %d\n\n", AllocationCount);
+
+    // get the distinct integers and their counts in increasing order
+    int n = intCounterSize(counter);
+    IntCount * counts = (IntCount *) malloc((n > 0 ? n : 1) * sizeof(IntCount));
+    if (counts == NULL) {
+        printf ("Unable to allocate memory for the counts... exiting");
+        exit (0);
+    }
+    AllocationCount++;
+    n = sortedIntCounts(counter, counts);
+
+    // write the results as the in-order traversal would
+    fprintf(out, "\nIntegers       Frequency\n\n");
+    for (int i = 0; i < n; i++)
+        fprintf(out, "%d %2d\n", counts[i].key, counts[i].count);
+    fprintf(out, "\n\n");
+
+    // free the counts and the counter and prove it by printing and
+    // displaying AllocationCount to equal zero
+    free(counts);
+    AllocationCount--;
+    counter = deleteIntCounter(counter);
+    printf("Allocation count after deleting the counter is %d\n\n", AllocationCount);
+} //end hashFrequencies
+
+// optimizeTree gathers the nodes in sorted order and the running totals of
+// their frequencies, prefix[i] being the total of the first i.  For a
+// small tree it then works out, for every run of neighbouring nodes from
+// first up to last, the lowest total cost of a subtree of just those
+// nodes, where a node's cost is its frequency times its depth.  A run's
+// cost is the total of its frequencies (every node is one level deeper
+// than the subtree's root) plus the cost of the runs on either side of the
+// best root.  Runs are worked out shortest first, so the costs needed are
+// already known.  Knuth showed the best root of a run never moves left when
+// the run is extended at either end, so only the roots between the best
+// roots of the two runs one shorter need trying, which makes the total
+// work O(n^2) rather than O(n^3).  The nodes are then relinked into the
+// best shape and their heights, sizes and weights are updated.
+// The tables use O(n^2) memory, so a larger tree uses linkWeightBalanced
+// instead, which needs only the running totals and O(n log n) time
+void optimizeTree(BinaryTree * bt)
+{
+    int n = subtreeSize(bt -> root);
+    if (n < 2) return;
+    TreeNodePtr * nodes = (TreeNodePtr *) malloc(n * sizeof(TreeNodePtr));
+    long * prefix = (long *) malloc((n + 1) * sizeof(long));
+    if ((nodes == NULL) || (prefix == NULL)) {
+        printf ("Unable to allocate memory to optimize the tree... exiting");
+        exit (0);
+    }
+    AllocationCount += 2;
+    collectNodes(bt -> root, nodes, 0);
+    prefix[0] = 0;
+    for (int i = 0; i < n; i++) prefix[i + 1] = prefix[i] + nodes[i] -> data.freq;
+
+    if (n > OPTIMALDPLIMIT)
+        bt -> root = linkWeightBalanced(nodes, prefix, 0, n - 1);
+    else {
+        // entry first * (n + 1) + last of each table is for the run of
+        // nodes from first up to (but not including) last
+        long * cost = (long *) malloc((size_t) (n + 1) * (n + 1) * sizeof(long));
+        int * best = (int *) malloc((size_t) (n + 1) * (n + 1) * sizeof(int));
+        if ((cost == NULL) || (best == NULL)) {
+            printf ("Unable to allocate memory to optimize the tree... exiting");
+            exit (0);
+        }
+        AllocationCount += 2;
+        for (int first = 0; first <= n; first++) cost[first * (n + 1) + first] = 0;
+        for (int length = 1; length <= n; length++)
+            for (int first = 0; first + length <= n; first++) {
+                int last = first + length;
+                int low = (length == 1) ? first : best[first * (n + 1) + last - 1];
+                int high = (length == 1) ? first : best[(first + 1) * (n + 1) + last];
+                long lowest = -1;
+                for (int root = low; root <= high; root++) {
+                    long c = cost[first * (n + 1) + root] + cost[(root + 1) * (n + 1) + last];
+                    if ((lowest < 0) || (c < lowest)) {
+                        lowest = c;
+                        best[first * (n + 1) + last] = root;
+                    }
+                }
+                cost[first * (n + 1) + last] = lowest + prefix[last] - prefix[first];
+            }
+        bt -> root = linkOptimal(nodes, best, n, 0, n);
+        free(cost);
+        free(best);
+        AllocationCount -= 2;
+    }
+    bt -> root -> parent = NULL;
+    free(nodes);
+    free(prefix);
+    AllocationCount -= 2;
+} //end optimizeTree
+
+// collectNodes is inOrder with copying the node's address as the "visit"
+int collectNodes(TreeNodePtr node, TreeNodePtr nodes[], int n)
+{
+    if (node != NULL) {
+        n = collectNodes(node -> left, nodes, n);
+        nodes[n++] = node;
+        n = collectNodes(node -> right, nodes, n);
+    }
+    return n;
+} //end collectNodes
+
+// linkOptimal makes the run's best root the root, with the runs on either
+// side of it as its subtrees, and updates the root once they are linked
+TreeNodePtr linkOptimal(TreeNodePtr nodes[], int best[], int n, int first, int last)
+{
+    if (first == last) return NULL;
+    int root = best[first * (n + 1) + last];
+    TreeNodePtr node = nodes[root];
+    node -> left = linkOptimal(nodes, best, n, first, root);
+    node -> right = linkOptimal(nodes, best, n, root + 1, last);
+    updateNode(node);
+    return node;
+} //end linkOptimal
+
+// linkWeightBalanced finds, by a binary search of the running totals, the
+// node whose share of the run's frequencies covers the run's halfway
+// point and makes it the root, so each subtree holds at most half of the
+// frequency.  A node with frequency w then ends up no more than about
+// log2(total / w) levels down, close to the best possible
+TreeNodePtr linkWeightBalanced(TreeNodePtr nodes[], long prefix[], int first, int last)
+{
+    if (first > last) return NULL;
+    // twice the halfway point, to stay with whole numbers
+    long half = prefix[first] + prefix[last + 1];
+    // find the last node whose frequencies start at or before halfway
+    int low = first, high = last;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (2 * prefix[middle] <= half) low = middle;
+        else high = middle - 1;
+    }
+    TreeNodePtr node = nodes[low];
+    node -> left = linkWeightBalanced(nodes, prefix, first, low - 1);
+    node -> right = linkWeightBalanced(nodes, prefix, low + 1, last);
+    updateNode(node);
+    return node;
+} //end linkWeightBalanced
+
+// buildBalancedFromSorted checks that the integers are in increasing order
+// (a BST cannot hold them otherwise) before building the tree
+TreeNodePtr buildBalancedFromSorted(NodeArena nodes, NodeData sorted[], int n)
+{
+    for (int i = 1; i < n; i++)
+        if (sorted[i - 1].num >= sorted[i].num) {
+            printf ("Integers to build a tree from are not in sorted order... exiting");
+            exit (0);
+        }
+    TreeNodePtr root = buildBalanced(nodes, sorted, 0, n - 1);
+    if (root != NULL) root -> parent = NULL;
+    return root;
+} //end buildBalancedFromSorted
+
+// buildBalanced makes a node for the middle integer and builds the integers
+// before and after it into its left and right subtrees.  The two halves
+// differ in size by at most one, so their heights do too.  Each integer is
+// made into a node once, with no comparisons, so the whole build is O(n).
+// The node is taken from the arena before its subtrees, so the top of
+// the tree, which every search passes through, sits together in memory
+TreeNodePtr buildBalanced(NodeArena nodes, NodeData sorted[], int first, int last)
+{
+    if (first > last) return NULL;
+    int middle = first + (last - first) / 2;
+    TreeNodePtr node = newTreeNode(nodes, sorted[middle]);
+    node -> left = buildBalanced(nodes, sorted, first, middle - 1);
+    node -> right = buildBalanced(nodes, sorted, middle + 1, last);
+    updateNode(node);
+    return node;
+} //end buildBalanced
+
+// rebalanceTree flattens the tree into an array of its nodes in in-order
+// and relinks them with linkBalanced.  No node is made or freed, so the
+// nodes keep their data and anything pointing at them stays good
+void rebalanceTree(BinaryTree * bt)
+{
+    int n = subtreeSize(bt -> root);
+    if (n < 2) return;
+    TreeNodePtr * nodes = (TreeNodePtr *) malloc(n * sizeof(TreeNodePtr));
+    if (nodes == NULL) {
+        printf ("Unable to allocate memory to rebalance the tree... exiting");
+        exit (0);
+    }
+    AllocationCount++;
+    collectNodes(bt -> root, nodes, 0);
+    bt -> root = linkBalanced(nodes, 0, n - 1);
+    bt -> root -> parent = NULL;
+    free(nodes);
+    AllocationCount--;
+} //end rebalanceTree
+
+// linkBalanced is buildBalanced for nodes that already exist
+TreeNodePtr linkBalanced(TreeNodePtr nodes[], int first, int last)
+{
+    if (first > last) return NULL;
+    int middle = first + (last - first) / 2;
+    TreeNodePtr node = nodes[middle];
+    node -> left = linkBalanced(nodes, first, middle - 1);
+    node -> right = linkBalanced(nodes, middle + 1, last);
+    updateNode(node);
+    return node;
+} //end linkBalanced
+
+// weightedDepth adds the node's frequency times its depth to the totals
+// of its subtrees, one level deeper
+long weightedDepth(TreeNodePtr node, int depth)
+{
+    if (node == NULL) return 0;
+    return (long) node -> data.freq * depth + weightedDepth(node -> left, depth + 1)
+           + weightedDepth(node -> right, depth + 1);
+} //end weightedDepth
+
+// bPlusFrequencies counts each integer read from the file in a B+tree,
+// bumping the count found or inserted just as findOrInsert's caller
+// does.  The output file is written by walking the leaves from the
+// smallest integer, and then the integers from RANGELOW to RANGEHIGH are
+// walked on their own.  Finally the integers and counts are copied out and
+// bulk loaded into a second B+tree, to compare its size with the first's
+void bPlusFrequencies(FILE * in, FILE * out)
+{
+    // integer is a scratch array used to get complete integers from the file
+    int integer, count;
+    BPlusTree tree = initBPlusTree();
+    while (getInt(in, &integer) == true)
+        (*bPlusFindOrInsert(tree, integer))++;
+    // print and display the number of items currently
+    // dynamically allocated after counting
+    printf("Allocation count after counting is %d (%ld nodes, %d levels)\n\n",
+           AllocationCount, tree -> numNodes, tree -> height);
+
+    // write the results as the in-order traversal would, copying them
+    // for the bulk load as they go
+    int n = (int) tree -> numKeys;
+    int * keys = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    int * counts = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    if ((keys == NULL) || (counts == NULL)) {
+        printf ("Unable to allocate memory for the counts... exiting");
+        exit (0);
+    }
+    AllocationCount += 2;
+    BPlusCursor cursor;
+    fprintf(out, "\nIntegers       Frequency\n\n");
+    bPlusSeek(tree, INT_MIN, &cursor);
+    for (int i = 0; bPlusNext(&cursor, &integer, &count); i++) {
+        fprintf(out, "%d %2d\n", integer, count);
+        keys[i] = integer;
+        counts[i] = count;
+    }
+    fprintf(out, "\n\n");
+
+    // total the occurrences of the integers in the range
+    long inRange = 0;
+    bPlusSeek(tree, RANGELOW, &cursor);
+    while (bPlusNext(&cursor, &integer, &count) && (integer <= RANGEHIGH))
+        inRange += count;
+    printf("%ld of the integers are from %d to %d\n\n", inRange, RANGELOW, RANGEHIGH);
+
+    // a tree bulk loaded from the same integers needs fewer nodes
+    BPlusTree loaded = bulkLoadBPlusTree(keys, counts, n);
+    printf("Bulk loading the same integers takes %ld nodes, %d levels\n\n",
+           loaded -> numNodes, loaded -> height);
+    loaded = deleteBPlusTree(loaded);
+
+    // free the copies and the tree and prove it by printing and
+    // displaying AllocationCount to equal zero
+    free(keys);
+    free(counts);
+    AllocationCount -= 2;
+    tree = deleteBPlusTree(tree);
+    printf("Allocation count after deleting the B+tree is %d\n\n", AllocationCount);
+} //end bPlusFrequencies
+
+// parallelCount works in four steps:
+//      1. The file is read into memory and cut into INGESTCHUNKS chunks of
+//          about the same size, each moved on to the next white space so
+//          that no integer is cut in two
+//      2. The threads parse the chunks.  Each integer needs at least two
+//          characters but the last, so a chunk of length characters has
+//          room for length / 2 + 1 integers
+//      3. Everything up to the first chunk that stopped is counted by the
+//          threads, each chunk into a BST of its own, which is then copied
+//          out in sorted order.  A chunk's tree cannot have more nodes than
+//          the chunk has integers, so its arena is given one slab of that
+//          many nodes before the threads start (by taking a node and giving
+//          it back), and the threads never allocate.  That keeps them from
+//          updating AllocationCount at the same time
+//      4. The sorted lists are merged by repeatedly taking the smallest
+//          integer at the front of any list, adding its frequency to the
+//          last merged integer if it is the same one, and the BST is built
+//          from the merged list with buildBalancedFromSorted
+void parallelCount(WorkStealingPool pool, FILE * in, BinaryTree * bt)
+{
+    // read the file into memory
+    fseek(in, 0, SEEK_END);
+    long length = ftell(in);
+    rewind(in);
+    char * text = (char *) malloc(length + 1);
+    IngestChunk * chunks = (IngestChunk *) malloc(INGESTCHUNKS * sizeof(IngestChunk));
+    if ((length < 0) || (text == NULL) || (chunks == NULL)) {
+        printf ("Unable to read the file into memory... exiting");
+        exit (0);
+    }
+    AllocationCount += 2;
+    length = (long) fread(text, 1, length, in);
+    const char * end = text + length;
+
+    // cut the text into chunks and make room for their integers
+    const char * start = text;
+    for (int i = 0; i < INGESTCHUNKS; i++) {
+        const char * cut = text + length * (i + 1) / INGESTCHUNKS;
+        if (cut < start) cut = start;
+        while ((cut < end) && !isspace((unsigned char) *cut)) cut++;
+        chunks[i].start = start;
+        chunks[i].end = cut;
+        chunks[i].integers = (int *) malloc(((cut - start) / 2 + 1) * sizeof(int));
+        if (chunks[i].integers == NULL) {
+            printf ("Unable to allocate memory for the integers... exiting");
+            exit (0);
+        }
+        AllocationCount++;
+        start = cut;
+    }
+    poolParallelFor(pool, 0, INGESTCHUNKS, 1, parseRange, chunks);
+
+    // only the chunks up to the first that stopped are counted
+    int used = 0;
+    while ((used < INGESTCHUNKS) && !chunks[used++].stopped) ;
+    long total = 0;
+    for (int i = 0; i < used; i++) {
+        int room = (chunks[i].count > 0) ? chunks[i].count : 1;
+        chunks[i].tree.root = NULL;
+        chunks[i].tree.nodes = initNodeArena(sizeof(TreeNode), room);
+        arenaAlloc(chunks[i].tree.nodes);
+        resetNodeArena(chunks[i].tree.nodes);
+        chunks[i].sorted = (NodeData *) malloc(room * sizeof(NodeData));
+        if (chunks[i].sorted == NULL) {
+            printf ("Unable to allocate memory for the counts... exiting");
+            exit (0);
+        }
+        AllocationCount++;
+    }
+    poolParallelFor(pool, 0, used, 1, countRange, chunks);
+    for (int i = 0; i < used; i++) total += chunks[i].distinct;
+
+    // merge the chunks' sorted lists.  front[i] is the index of the first
+    // NodeData of chunk i not merged yet
+    NodeData * merged = (NodeData *) malloc((total > 0 ? total : 1) * sizeof(NodeData));
+    int * front = (int *) calloc(INGESTCHUNKS, sizeof(int));
+    if ((merged == NULL) || (front == NULL)) {
+        printf ("Unable to allocate memory to merge the counts... exiting");
+        exit (0);
+    }
+    AllocationCount += 2;
+    int n = 0;
+    for (;;) {
+        int smallest = -1;
+        for (int i = 0; i < used; i++)
+            if ((front[i] < chunks[i].distinct) && ((smallest < 0)
+                || (chunks[i].sorted[front[i]].num < chunks[smallest].sorted[front[smallest]].num)))
+                smallest = i;
+        if (smallest < 0) break;
+        NodeData next = chunks[smallest].sorted[front[smallest]++];
+        if ((n > 0) && (merged[n - 1].num == next.num))
+            merged[n - 1].freq += next.freq;
+        else
+            merged[n++] = next;
+    }
+    bt -> root = buildBalancedFromSorted(bt -> nodes, merged, n);
+
+    // free the chunks, their trees and the merged list
+    for (int i = 0; i < INGESTCHUNKS; i++) {
+        if (i < used) {
+            deleteTree(&chunks[i].tree, 0);
+            free(chunks[i].sorted);
+            AllocationCount--;
+        }
+        free(chunks[i].integers);
+        AllocationCount--;
+    }
+    free(merged);
+    free(front);
+    free(chunks);
+    free(text);
+    AllocationCount -= 4;
+} //end parallelCount
+
+// parseRange parses each of its chunks as getInt's fscanf() would: white
+// space is skipped, and an integer is an optional sign and one or more
+// digits.  Anything else stops the chunk
+void parseRange(void * job, int first, int last)
+{
+    IngestChunk * chunks = (IngestChunk *) job;
+    for (int i = first; i < last; i++) {
+        IngestChunk * chunk = &chunks[i];
+        const char * p = chunk -> start;
+        chunk -> count = 0;
+        chunk -> stopped = false;
+        for (;;) {
+            while ((p < chunk -> end) && isspace((unsigned char) *p)) p++;
+            if (p == chunk -> end) break;
+            bool negative = (*p == '-');
+            if ((*p == '-') || (*p == '+')) p++;
+            if ((p == chunk -> end) || !isdigit((unsigned char) *p)) {
+                chunk -> stopped = true;
+                break;
+            }
+            long value = 0;
+            while ((p < chunk -> end) && isdigit((unsigned char) *p))
+                value = value * 10 + (*p++ - '0');
+            chunk -> integers[chunk -> count++] = (int) (negative ? -value : value);
+        }
+    }
+} //end parseRange
+
+// countRange counts each of its chunks' integers in the chunk's tree, just
+// as main does for the whole file, and copies the tree out in sorted order
+void countRange(void * job, int first, int last)
+{
+    IngestChunk * chunks = (IngestChunk *) job;
+    for (int i = first; i < last; i++) {
+        IngestChunk * chunk = &chunks[i];
+        for (int k = 0; k < chunk -> count; k++)
+            findOrInsert(&chunk -> tree, newNodeData(chunk -> integers[k], 1));
+        chunk -> distinct = collectInOrder(chunk -> tree.root, chunk -> sorted, 0);
+    }
+} //end countRange
+
+// splayFrequencies counts each integer read from the file in a splay tree.
+// The output file is written by seeking the smallest integer and then one
+// more than each integer found, which takes O(n) time in all however the
+// tree is shaped, and leaves it with no recursion to run out of stack, as
+// an in-order traversal of a splay tree of sorted integers could (such a
+// tree is a single long path)
+void splayFrequencies(FILE * in, FILE * out)
+{
+    // integer is a scratch array used to get complete integers from the file
+    int integer;
+    SplayTree tree = initSplayTree();
+    while (getInt(in, &integer) == true)
+        splayFindOrInsert(tree, integer, 1);
+    // print and display the number of items currently
+    // dynamically allocated after counting
+    printf("Allocation count after counting is %d (%ld different integers)\n\n",
+           AllocationCount, tree -> numKeys);
+
+    // write the results as the in-order traversal would
+    fprintf(out, "\nIntegers       Frequency\n\n");
+    SplayNode * node = splaySeek(tree, INT_MIN);
+    while (node != NULL) {
+        fprintf(out, "%d %2d\n", node -> key, node -> count);
+        // stop after INT_MAX, as there is no integer after it to seek
+        node = (node -> key == INT_MAX) ? NULL : splaySeek(tree, node -> key + 1);
+    }
+    fprintf(out, "\n\n");
+
+    // free the tree and prove it by printing and displaying
+    // AllocationCount to equal zero
+    tree = deleteSplayTree(tree);
+    printf("Allocation count after deleting the splay tree is %d\n\n", AllocationCount);
+} //end splayFrequencies
+
+// benchmarkSplayTree makes a stream of BENCHINTEGERS integers of each kind
+// and times counting it with findOrInsert in a BST and with
+// splayFindOrInsert in a splay tree.  The BST is the AVL tree of BSTMODE,
+// since a BST that is not kept balanced would take O(n^2) time on the
+// sorted stream.  The BST's balance makes every search O(log n), but the
+// splay tree's are short for the integers that keep coming up, which is
+// most of the Zipf stream (and, in the sorted stream, each integer is
+// counted several times in a row while it is at the root)
+void benchmarkSplayTree(void)
+{
+    static const char * kindNames[] = {"uniform", "sorted", "Zipf"};
+    int * stream = (int *) malloc(BENCHINTEGERS * sizeof(int));
+    if (stream == NULL) {
+        printf ("Unable to allocate memory for the benchmark... exiting");
+        exit (0);
+    }
+    AllocationCount++;
+    srand(BENCHSEED);
+    printf("Seconds to count %d integers    BST    splay tree\n", BENCHINTEGERS);
+    for (StreamKind kind = UNIFORMSTREAM; kind <= ZIPFSTREAM; kind++) {
+        fillStream(stream, BENCHINTEGERS, kind);
+
+        clock_t start = clock();
+        BinaryTree bst;
+        bst.root = NULL;
+        bst.nodes = initNodeArena(sizeof(TreeNode), NODESPERSLAB);
+        for (int i = 0; i < BENCHINTEGERS; i++)
+            findOrInsert(&bst, newNodeData(stream[i], 1));
+        double bstSeconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+        start = clock();
+        SplayTree tree = initSplayTree();
+        for (int i = 0; i < BENCHINTEGERS; i++)
+            splayFindOrInsert(tree, stream[i], 1);
+        double splaySeconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+        // both trees must have found the same different integers
+        if (subtreeSize(bst.root) != tree -> numKeys) {
+            printf ("The BST and the splay tree counted differently... exiting");
+            exit (0);
+        }
+        printf("  %-28s %6.3f %9.3f\n", kindNames[kind], bstSeconds, splaySeconds);
+        deleteTree(&bst, 0);
+        tree = deleteSplayTree(tree);
+    }
+    free(stream);
+    AllocationCount--;
+    printf("\nAllocation count after the benchmark is %d\n\n", AllocationCount);
+} //end benchmarkSplayTree
+
+// fillStream draws each uniform integer from rand().  The sorted stream
+// goes up through the integers evenly, repeating each one about
+// BENCHINTEGERS / BENCHKEYS times.  For the Zipf stream, the running totals
+// of 1/r for each rank r are worked out once, and then each integer is the
+// rank whose share of the total a random point falls in, found by binary
+// search, scattered by ZIPFSCATTER
+void fillStream(int stream[], int n, StreamKind kind)
+{
+    if (kind == UNIFORMSTREAM)
+        for (int i = 0; i < n; i++)
+            stream[i] = (int) ((double) rand() / ((double) RAND_MAX + 1) * BENCHKEYS);
+    else if (kind == SORTEDSTREAM)
+        for (int i = 0; i < n; i++)
+            stream[i] = (int) ((long) i * BENCHKEYS / n);
+    else {
+        double * total = (double *) malloc(BENCHKEYS * sizeof(double));
+        if (total == NULL) {
+            printf ("Unable to allocate memory for the benchmark... exiting");
+            exit (0);
+        }
+        AllocationCount++;
+        // total[r] is the total of 1/(k+1) for ranks k up to r
+        double sum = 0;
+        for (int r = 0; r < BENCHKEYS; r++) {
+            sum += 1.0 / (r + 1);
+            total[r] = sum;
+        }
+        for (int i = 0; i < n; i++) {
+            double point = (double) rand() / ((double) RAND_MAX + 1) * sum;
+            // find the first rank whose running total passes the point
+            int low = 0, high = BENCHKEYS - 1;
+            while (low < high) {
+                int middle = (low + high) / 2;
+                if (total[middle] > point) high = middle;
+                else low = middle + 1;
+            }
+            stream[i] = (int) ((long) low * ZIPFSCATTER % BENCHKEYS);
+        }
+        free(total);
         AllocationCount--;
     }
-}
+} //end fillStream
 
 // newNodeData is a utility that builds a NodeData structure from
 // the user data fields it receives as input.  In this case, it is a integer
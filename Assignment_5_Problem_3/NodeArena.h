@@ -0,0 +1,50 @@
+#ifndef NODEARENA_H_INCLUDED
+#define NODEARENA_H_INCLUDED
+
+// A NodeArena hands out fixed size items (such as tree nodes) from large
+// blocks of memory called slabs, instead of calling malloc() for each one.
+// Items allocated one after another sit next to each other in memory, so
+// walking a tree built in order touches memory in order, and the whole
+// arena is given back with one free() per slab instead of one per item.
+// Items cannot be freed one at a time: they all go when the arena is
+// deleted or reset.
+
+// size_t is defined in stddef.h
+#include <stddef.h>
+
+// ArenaSlab struct is the header at the front of each slab. The items
+// follow it. next links the slabs together (newest first), used is the
+// number of items handed out from this slab and capacity is how many it holds
+typedef struct arenaSlab {
+    struct arenaSlab *next;
+    size_t used;
+    size_t capacity;
+} ArenaSlab;
+
+// NodeArenaInfo struct holds the size of each item (rounded up so every
+// item is suitably aligned), how many items a new slab holds, the list of
+// slabs and the number of slabs and items allocated so far
+typedef struct {
+    size_t itemSize;
+    size_t itemsPerSlab;
+    ArenaSlab *slabs;
+    int numSlabs;
+    long numItems;
+} NodeArenaInfo, *NodeArena;
+
+// initNodeArena allocates an empty arena for items of itemSize bytes,
+// taking itemsPerSlab items' worth of memory at a time
+NodeArena   initNodeArena   (size_t itemSize, int itemsPerSlab);
+// arenaAlloc returns memory for one item, allocating a new slab if the
+// current one is full. The memory is not cleared.
+void *      arenaAlloc      (NodeArena arena);
+// arenaItems returns how many items have been allocated from the arena
+long        arenaItems      (NodeArena arena);
+// resetNodeArena gives back every item but keeps the newest slab, so the
+// arena can be filled again without calling malloc()
+void        resetNodeArena  (NodeArena arena);
+// deleteNodeArena frees every slab and the arena itself, giving back all
+// items at once. It returns NULL to show the arena no longer exists
+NodeArena   deleteNodeArena (NodeArena arena);
+
+#endif // NODEARENA_H_INCLUDED
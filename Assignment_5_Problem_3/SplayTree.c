@@ -0,0 +1,162 @@
+// SplayTree.c keeps integer keys and their counts in a splay tree.
+//
+// Splaying is done top down, in one pass from the root.  The nodes passed
+// on the way down are hung onto two side trees: those found to be larger
+// than the key onto the leftmost edge of the right tree, those smaller onto
+// the rightmost edge of the left tree.  When two steps in a row go the same
+// way, the pair is rotated first, which is what shortens long paths.  At the
+// end the node reached becomes the root, with the left and right trees as
+// its subtrees.  Nothing is done on the way back up, so there is no
+// recursion and no parent links, however deep the tree has become.
+
+// printf provides the error message when memory runs out
+#include <stdio.h>
+// stdlib provides malloc(), free() and exit()
+#include <stdlib.h>
+// the tree's own declarations are included for consistency checking
+#include "SplayTree.h"
+
+// SPLAYNODESPERSLAB is the number of nodes the node arena allocates at a time
+#define SPLAYNODESPERSLAB 1024
+
+// To make sure we are allocating and deallocating dynamic memory,
+// AllocationCount (defined with main) is updated for the tree itself (the
+// node arena updates it for its slabs)
+extern int AllocationCount;
+
+// splay is a local function that splays the subtree whose root is node
+// for key and returns its new root: the node holding key, or if there is
+// none, the last node reached looking for it
+static SplayNode * splay (SplayNode * node, int key);
+
+// initSplayTree allocates a tree with no nodes and the arena for them
+SplayTree initSplayTree (void)
+{
+    SplayTree tree = (SplayTree) malloc(sizeof(SplayTreeInfo));
+    if (tree == NULL) {
+        printf ("Unable to create a splay tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    tree -> root = NULL;
+    tree -> nodes = initNodeArena(sizeof(SplayNode), SPLAYNODESPERSLAB);
+    tree -> numKeys = 0;
+    return tree;
+} // end initSplayTree
+
+// splayFindOrInsert splays the tree for the key.  If the root is then not
+// the key, it is the key's nearest neighbour, so the new node can go above
+// it: a new key smaller than the root takes the root's left subtree and
+// the root, the other way round for a larger key
+SplayNode * splayFindOrInsert (SplayTree tree, int key, int count)
+{
+    SplayNode * root = splay(tree -> root, key);
+    if ((root == NULL) || (root -> key != key)) {
+        SplayNode * node = (SplayNode *) arenaAlloc(tree -> nodes);
+        node -> key = key;
+        node -> count = 0;
+        if (root == NULL)
+            node -> left = node -> right = NULL;
+        else if (key < root -> key) {
+            node -> left = root -> left;
+            node -> right = root;
+            root -> left = NULL;
+        } else {
+            node -> right = root -> right;
+            node -> left = root;
+            root -> right = NULL;
+        }
+        tree -> numKeys++;
+        root = node;
+    }
+    root -> count += count;
+    tree -> root = root;
+    return root;
+} // end splayFindOrInsert
+
+// splayFind splays the tree for the key and looks at the root
+SplayNode * splayFind (SplayTree tree, int key)
+{
+    tree -> root = splay(tree -> root, key);
+    if ((tree -> root == NULL) || (tree -> root -> key != key)) return NULL;
+    return tree -> root;
+} // end splayFind
+
+// splaySeek splays the tree for the key.  If the root is then smaller than
+// the key it is the key's predecessor, so the answer is the smallest key
+// of its right subtree.  Splaying that subtree for the key (which is
+// smaller than all of it) brings its smallest key to its top with no left
+// subtree, and one rotation lifts it to the root
+SplayNode * splaySeek (SplayTree tree, int key)
+{
+    SplayNode * root = splay(tree -> root, key);
+    tree -> root = root;
+    if (root == NULL) return NULL;
+    if (root -> key >= key) return root;
+    if (root -> right == NULL) return NULL;
+    SplayNode * next = splay(root -> right, key);
+    root -> right = NULL;
+    next -> left = root;
+    tree -> root = next;
+    return next;
+} // end splaySeek
+
+// deleteSplayTree frees the nodes by deleting their arena, then the tree
+SplayTree deleteSplayTree (SplayTree tree)
+{
+    deleteNodeArena(tree -> nodes);
+    free(tree);
+    AllocationCount--;
+    return NULL;
+} // end deleteSplayTree
+
+// splay walks down from node.  header stands in for the roots of the left
+// and right trees: its right link will hold the left tree and its left
+// link the right tree, and last and first are the nodes of the left and
+// right trees that the next smaller or larger node is hung from
+SplayNode * splay (SplayNode * node, int key)
+{
+    if (node == NULL) return NULL;
+    SplayNode header;
+    header.left = header.right = NULL;
+    SplayNode * last = &header, * first = &header;
+    for (;;) {
+        if (key < node -> key) {
+            if (node -> left == NULL) break;
+            if (key < node -> left -> key) {
+                // two steps left, so rotate right first
+                SplayNode * child = node -> left;
+                node -> left = child -> right;
+                child -> right = node;
+                node = child;
+                if (node -> left == NULL) break;
+            }
+            // node and its right subtree are larger than the key
+            first -> left = node;
+            first = node;
+            node = node -> left;
+        } else if (key > node -> key) {
+            if (node -> right == NULL) break;
+            if (key > node -> right -> key) {
+                // two steps right, so rotate left first
+                SplayNode * child = node -> right;
+                node -> right = child -> left;
+                child -> left = node;
+                node = child;
+                if (node -> right == NULL) break;
+            }
+            // node and its left subtree are smaller than the key
+            last -> right = node;
+            last = node;
+            node = node -> right;
+        } else
+            break;
+    }
+    // put the node's subtrees on the ends of the side trees and the side
+    // trees under the node
+    last -> right = node -> left;
+    first -> left = node -> right;
+    node -> left = header.right;
+    node -> right = header.left;
+    return node;
+} // end splay
@@ -0,0 +1,51 @@
+#ifndef SPLAYTREE_H_INCLUDED
+#define SPLAYTREE_H_INCLUDED
+
+// A SplayTree is a binary search tree of integer keys and their counts that
+// moves every key it finds or adds up to the root, rotating the nodes on
+// the way so that the path to it is roughly halved.  It keeps no balance
+// information, and a single search can be slow, but any sequence of m
+// operations takes O(m log n) time.  More usefully, a key that is asked for
+// often stays near the root, so when a few keys make up most of the
+// searches (as in a Zipf distribution) those searches are short, and
+// walking the keys in order takes O(n) time in all.
+//
+// The nodes come from a NodeArena, so the whole tree is freed at once.
+
+// the nodes are allocated from a NodeArena
+#include "NodeArena.h"
+
+// SplayNode struct is a node of the tree: a key, how many times it has
+// been counted and the links to the subtrees of smaller and larger keys
+typedef struct splayNode {
+    int key;
+    int count;
+    struct splayNode *left, *right;
+} SplayNode;
+
+// SplayTreeInfo struct holds the root node, the arena the nodes come from
+// and the number of keys in the tree
+typedef struct {
+    SplayNode *root;
+    NodeArena nodes;
+    long numKeys;
+} SplayTreeInfo, *SplayTree;
+
+// initSplayTree allocates an empty tree
+SplayTree   initSplayTree     (void);
+// splayFindOrInsert adds count to the key's count, first adding the key
+// with a count of 0 if it is not in the tree, and returns the key's node,
+// which is now the root
+SplayNode * splayFindOrInsert (SplayTree tree, int key, int count);
+// splayFind returns the key's node, now the root, or NULL if the key is
+// not in the tree
+SplayNode * splayFind         (SplayTree tree, int key);
+// splaySeek returns the node of the smallest key not less than key, now
+// the root, or NULL if there is none.  Seeking INT_MIN and then one more
+// than each key found steps through the keys in order
+SplayNode * splaySeek         (SplayTree tree, int key);
+// deleteSplayTree frees every node and the tree. It returns NULL to show
+// the tree no longer exists
+SplayTree   deleteSplayTree   (SplayTree tree);
+
+#endif // SPLAYTREE_H_INCLUDED
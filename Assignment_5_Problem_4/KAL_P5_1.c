@@ -1,28 +1,65 @@
 // Program P5.1 from Kalicharan, modified to make it easier
 // to document and understand.
 //
-// It uses recursive implementations of pre, in and post order
-// traversals.
-//
 // An additonal modification is the addition of the parent linkage
 // that can be used to traverse from a node back through its parent.
 //
+// The pre, in and post order traversals are done with TreeIterators,
+// which use the parent links to step from each node to the next one in
+// the traversal order.  An iterator only remembers the next node, so a
+// traversal can be stopped and picked up again at any point and needs
+// no stack, however deep the tree is.
+//
+// The tree can also be built as a CompactTree, which keeps its nodes in one
+// array and links them by 32 bit array indexes instead of pointers.  Each
+// node holds the offset of its word in a StringPool, which stores each
+// different word just once, rather than a copy of the word, so a compact
+// node takes 16 bytes where a TreeNode takes 48.
+//
+// A compact tree can be saved to a binary file that holds a header, the
+// array of nodes and the characters of the string pool, just as they are
+// in memory.  Loading the file maps it into memory (with mmap) and uses
+// the nodes and words where they lie, so nothing is parsed or copied and a
+// page of the file is only read when a traversal first touches it.
+//
+// The tree is read by buildTreeIterative, which keeps its own stack
+// instead of recursing and reads the file a buffer at a time, so a file
+// describing a very deep tree can still be read.  The recursive buildTree
+// it replaces is kept for comparison.
+//
 // This program is designed to demonstrate building a binary tree. It
 // consists of functions and definitions for the binary tree including
 // building a tree, pre-order/in-order/post-order transversal, visit
 // (printing a nodes name) and deleting the binary tree. AllocationCount
 // will tell how many things are currently dynamically allocated.
-// It uses a recursive routine, that is a routine which calls itself.
-// It is used in this program while searching a tree to delete all
-// of its nodes and free memory.
+// It uses a recursive routine, that is a routine which calls itself,
+// in buildTree, which is kept for comparison with buildTreeIterative.
 
+// mmap() and fstat() are POSIX functions, which this asks the C library
+// to declare even though the program is compiled as plain C99
+#define _POSIX_C_SOURCE 200809L
 // printf and reading a FILE support
 #include <stdio.h>
 // we will use strcpy() and strcmp() from string.h
 #include <string.h>
 // stdlib provides the definition of NULL and the declarations for
-// malloc() and free()
+// malloc(), realloc() and free()
 #include <stdlib.h>
+// we will use isspace() from ctype.h to find where words end
+#include <ctype.h>
+// the tree's nodes are allocated from a NodeArena
+#include "NodeArena.h"
+// uint32_t, used for the indexes of a compact tree, is defined in stdint.h
+#include <stdint.h>
+// the words of a compact tree are kept in a StringPool
+#include "StringPool.h"
+// a saved compact tree is mapped into memory with mmap() from sys/mman.h,
+// after finding its size with fstat() from sys/stat.h.  Windows has
+// neither, so there the file is read into memory instead
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 // this is an int constant that limits a node/read-in-word's name to a maximum
 // length, or number of characters, to this set value
@@ -30,6 +67,28 @@
 // this is a string constant that sets the name of the file to open and read in
 // words from
 #define FILENAME "btree.in"
+// this is an int constant that sets how many bytes of the file are read
+// into memory at a time when picking out words
+#define TOKENBUFFERSIZE 65536
+// this is an int constant that sets how many links the stack used by
+// buildTreeIterative can hold before it has to be made larger
+#define INITIALSTACKSIZE 64
+// this is an int constant that sets how many tree nodes each slab of the
+// node arena holds
+#define NODESPERSLAB 1024
+// this is an int constant that sets how many nodes a compact tree's array
+// starts with room for
+#define INITIALCOMPACTNODES 64
+// NOINDEX is the index a compact tree uses where a TreeNode would have a
+// NULL link
+#define NOINDEX UINT32_MAX
+// this is a string constant that sets the name of the file a compact tree
+// is saved to and loaded from
+#define BINARYFILENAME "btree.bin"
+// these are the 4 characters a saved compact tree starts with and the
+// version of the layout that follows them
+#define COMPACTMAGIC "CTRE"
+#define COMPACTVERSION 1
 
 // To make sure we are allocating and deallocating dynamic memory,
 // variable AllocationCount is declared and referenced by any other
@@ -60,16 +119,121 @@ typedef struct treeNode {
 // The TreeNode struct is important as it will be
 // the binary tree's root node and is referenced as
 // -> root
+// It also contains the NodeArena that all of the tree's
+// nodes are allocated from, referenced as -> nodes
 typedef struct {
     TreeNodePtr root;
+    NodeArena nodes;
 } BinaryTree;
 
+// TokenReader struct holds the file words are read from and a buffer of
+// bytes already read from it, so that words are picked out of memory
+// rather than with one fscanf() call each. next is the position of the
+// next unused byte in the buffer and end is how many bytes it holds
+typedef struct {
+    FILE * in;
+    char buffer[TOKENBUFFERSIZE];
+    int next;
+    int end;
+} TokenReader;
+
+// PendingLink struct is one entry on the stack used by buildTreeIterative.
+// It holds the address of a left or right link (or the root) that is still
+// to be filled in and the node that link belongs to, which becomes the
+// parent of the node read for it
+typedef struct {
+    TreeNodePtr *link;
+    TreeNodePtr parent;
+} PendingLink;
+
+// TraversalOrder says which order a TreeIterator visits the nodes in
+typedef enum {PREORDER, INORDER, POSTORDER} TraversalOrder;
+
+// TreeIterator struct holds a traversal in progress: the order it visits
+// the nodes in, the root of the (sub)tree being traversed, so the
+// traversal never climbs above it, and the node it will return next
+// (NULL once every node has been returned)
+typedef struct {
+    TraversalOrder order;
+    TreeNodePtr root;
+    TreeNodePtr next;
+} TreeIterator;
+
+// CompactNode struct is one node of a compact tree.  word is the offset
+// of the node's name in the tree's string pool, and left, right and parent
+// are the indexes of the node's children and parent in the tree's array
+// of nodes, NOINDEX where there is none
+typedef struct {
+    uint32_t word;
+    uint32_t left, right, parent;
+} CompactNode;
+
+// CompactTreeInfo struct holds a compact tree: the array of nodes, count
+// of the capacity nodes allocated being in use, the index of the root node
+// (NOINDEX if the tree is empty) and the string pool of the node's names.
+// A tree loaded from a file has no string pool.  Instead mapping is the
+// file's mappingSize bytes in memory, and nodes and mappedWords (the
+// mappedLength characters of the names) point into it
+typedef struct {
+    CompactNode *nodes;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t root;
+    StringPool words;
+    void *mapping;
+    size_t mappingSize;
+    const char *mappedWords;
+    uint32_t mappedLength;
+} CompactTreeInfo, *CompactTree;
+
+// CompactFileHeader struct is the start of a saved compact tree: the
+// characters of COMPACTMAGIC, the layout's version, the number of nodes,
+// the index of the root node and the number of characters of the names.
+// The nodes follow it, then the characters.  The numbers are saved in the
+// computer's own byte order, so the magic characters are checked as a
+// sign the file was not written by some other program.  reserved pads
+// the header to 32 bytes
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t root;
+    uint32_t wordsLength;
+    uint32_t reserved[3];
+} CompactFileHeader;
+
+// PendingIndex struct is one entry on the stack used by buildCompactTree.
+// It holds the index of the node whose left or right link (as given by
+// right) is still to be filled in, or NOINDEX for the root
+typedef struct {
+    uint32_t parent;
+    int right;
+} PendingIndex;
+
+// CompactIterator struct holds a traversal of a compact tree in progress,
+// just as a TreeIterator does for a tree of TreeNodes
+typedef struct {
+    TraversalOrder order;
+    CompactTree tree;
+    uint32_t root;
+    uint32_t next;
+} CompactIterator;
+
 // buildTree creates all nodes for a binary tree and assigns each one a word
 // with maximum length as its name. The word is grabbed from an opened file
 // and this function allocates memory for each newly created
-// node. It takes a file name and a binary tree root node as arguments.
+// node from a node arena. It takes a file name, a binary tree root node
+// and the arena as arguments.
 // It returns the node which gets created and assigned a name.
-TreeNodePtr buildTree         (FILE * in, TreeNodePtr nodeParent);
+TreeNodePtr buildTree         (FILE * in, TreeNodePtr nodeParent, NodeArena nodes);
+// buildTreeIterative builds the same tree as buildTree from the same file,
+// but keeps the links still to be filled in on a stack of its own rather
+// than recursing, so the depth of the tree is limited only by memory.
+// It takes the file and the node arena and returns the root node.
+TreeNodePtr buildTreeIterative (FILE * in, NodeArena nodes);
+// nextToken takes a TokenReader and a char array, fills the array with the
+// next word of the file and returns 1, or returns 0 if there are no words left
+int         nextToken         (TokenReader * reader, char word[]);
 // Pre-order traversal of a tree.
 // First visit the root node, then the left subtree and finally the right subtree.
 // Every node may represent a subtree itself.
@@ -82,6 +246,15 @@ void        inOrder           (TreeNodePtr nodeP);
 // First visit the left subtree, then the right subtree and finally the root node.
 // Every node may represent a subtree itself.
 void        postOrder         (TreeNodePtr nodeP);
+// initIterator sets up an iterator to traverse the tree below root in the
+// given order. It takes the iterator, root and order and returns nothing.
+void        initIterator      (TreeIterator * it, TreeNodePtr root, TraversalOrder order);
+// nextNode returns the iterator's next node and moves on to the one after
+// it, or returns NULL once the traversal is complete
+TreeNodePtr nextNode          (TreeIterator * it);
+// firstPostOrder returns the first node of the post-order traversal of
+// the subtree below nodeP, the leaf reached by going left whenever possible
+TreeNodePtr firstPostOrder    (TreeNodePtr nodeP);
 // Visit takes a node to print and display its name, a letter.
 // It returns nothing
 void        visit             (TreeNodePtr nodeP);
@@ -89,9 +262,49 @@ void        visit             (TreeNodePtr nodeP);
 // a node's name, parent, left and right children and left and right
 // siblings. It takes a node and returns nothing.
 void        postOrderNodeDump (TreeNodePtr nodeP);
-// deleteTree() deletes the frees the storage that was allocated by the call
-// to buildTree()
-void deleteTree(TreeNodePtr nodeParent);
+// dumpNode prints the line postOrderNodeDump prints for one node
+void        dumpNode          (TreeNodePtr nodeP);
+// deleteTree() frees all of the tree's nodes at once by deleting its node
+// arena. If verbose is not 0, it first lists the nodes being freed.
+void deleteTree(BinaryTree * bt, int verbose);
+// buildCompactTree builds the tree described by the file as a compact
+// tree, in the same way as buildTreeIterative, and returns it
+CompactTree buildCompactTree  (FILE * in);
+// addCompactNode adds a node with the given name and parent to a compact
+// tree and returns its index
+uint32_t    addCompactNode    (CompactTree ct, const char * word, uint32_t parent);
+// compactWord returns the name of a compact tree's node
+const char * compactWord      (CompactTree ct, uint32_t index);
+// initCompactIterator and nextCompactNode traverse a compact tree in the
+// same way as initIterator and nextNode, returning NOINDEX at the end
+void        initCompactIterator (CompactIterator * it, CompactTree ct, TraversalOrder order);
+uint32_t    nextCompactNode   (CompactIterator * it);
+// firstCompactPostOrder returns the first node of the post-order
+// traversal of the subtree below a compact tree's node
+uint32_t    firstCompactPostOrder (CompactTree ct, uint32_t index);
+// compactTraversal prints the names of a compact tree's nodes in the
+// given order
+void        compactTraversal  (CompactTree ct, TraversalOrder order);
+// compactNodeDump prints the same table as postOrderNodeDump for a
+// compact tree
+void        compactNodeDump   (CompactTree ct);
+// compactTreeBytes returns the memory a compact tree uses
+long        compactTreeBytes  (CompactTree ct);
+// deleteCompactTree frees a compact tree and returns NULL
+CompactTree deleteCompactTree (CompactTree ct);
+// saveCompactTree writes a compact tree to the named binary file.  It
+// returns 1 if it was written and 0 if it could not be
+int         saveCompactTree   (CompactTree ct, const char * filename);
+// loadCompactTree maps the named binary file into memory as a compact
+// tree and returns it, or returns NULL if the file cannot be read or is
+// not a saved compact tree
+CompactTree loadCompactTree   (const char * filename);
+// checkCompactTree returns 1 if every index and name offset of a loaded
+// compact tree is in range and its links form one tree, and 0 otherwise
+int         checkCompactTree  (CompactTree ct);
+// printFreedNodes lists the nodes of a tree in post-order as they
+// are about to be freed by deleteTree()
+void        printFreedNodes   (TreeNodePtr nodeP);
 
 // the main takes no arguments, but opens a file to read in
 // if the file cannot be opened, it prints a message and
@@ -102,9 +315,9 @@ void deleteTree(TreeNodePtr nodeParent);
 // conducting pre-order/in-order/post-order transversals
 // while printing out the results as names of nodes in
 // the order of the respective transversal. After all
-// transversals, the tree is deleted by searching for the lowest
-// node using post-order transversal and deleting and freeing
-// that node until no nodes exist. Then the binary tree root is
+// transversals, the tree's nodes are listed in post-order
+// and then all freed at once by deleting the node arena they
+// were allocated from. Then the binary tree root is
 // set to NULL to reflect that the binary tree no longer exists.
 // Then the main calls an in-order transversal to prove the
 // tree no longer exists and that no node names are printed
@@ -124,14 +337,17 @@ int main()
     // allocated
     printf("Allocation count starts at %d\n", AllocationCount);
     // initialize a new binary tree to prepare for building its nodes
+    // and the arena its nodes will be allocated from
     BinaryTree bt;
+    bt.nodes = initNodeArena(sizeof(TreeNode), NODESPERSLAB);
     // build the binary tree using the newly initialized binary tree
     // create nodes for each of the words contained in the file
-    // it takes a NULL argument along with the file name because
-    // the node parent (in this case the root) is still NULL
-    // from being newly initialized
-    bt.root = buildTree(in, NULL);
-    printf("Allocation count after tree build is %d\n", AllocationCount);
+    // the iterative builder is used so that a tree of any depth can
+    // be read; the root node's parent is NULL
+    bt.root = buildTreeIterative(in, bt.nodes);
+    printf("Allocation count after tree build is %d (%ld nodes)\n", AllocationCount, arenaItems(bt.nodes));
+    // remember how much memory the tree's nodes take
+    long treeBytes = arenaItems(bt.nodes) * (long) sizeof(TreeNode);
     // Dp a pre-order traversal of a tree.
     // First visit the root node, then the left subtree and finally the right subtree.
     printf("\nThe pre-order traversal is: ");
@@ -149,11 +365,11 @@ int main()
     printf("node\tparent\tlchild\trchild\tlsib\trsib\n");
     // print node, parent, left/right children and siblings
     postOrderNodeDump (bt.root);
-    // delete the binary tree and free all node memory
+    // delete the binary tree and free all node memory, listing
+    // the nodes as they go. This also sets the tree to NULL to
+    // reflect the binary tree no longer exists
     printf("\nStarting tree deletion...\n");
-    deleteTree(bt.root);
-    // set the tree to NULL to reflect the binary tree no longer exists
-    bt.root = NULL;
+    deleteTree(&bt, 1);
     // prove the binary tree does not exist by printing and displaying
     // AllocationCount to equal zero and conduct a final in-order transversal
     // Nothing will print
@@ -161,6 +377,41 @@ int main()
     printf("\n\nThe in-order traversal is now: \n");
     inOrder(bt.root);
     printf("back from call to in-order. Nothing should have printed.\n");
+    // build the tree again from the same file as a compact tree and
+    // repeat the traversals and the dump, which should print the same
+    rewind(in);
+    CompactTree ct = buildCompactTree(in);
+    printf("\nAllocation count after compact tree build is %d (%u nodes, %u different words)\n",
+           AllocationCount, ct -> count, ct -> words -> numStrings);
+    printf("\nThe compact pre-order traversal is: ");
+    compactTraversal(ct, PREORDER);
+    printf("\n\nThe compact in-order traversal is: ");
+    compactTraversal(ct, INORDER);
+    printf("\n\nThe compact post-order traversal is: ");
+    compactTraversal(ct, POSTORDER);
+    printf("\n\n");
+    printf("node\tparent\tlchild\trchild\tlsib\trsib\n");
+    compactNodeDump(ct);
+    // compare the memory used by each kind of tree
+    printf("\nThe tree's nodes took %ld bytes, the compact tree takes %ld bytes\n",
+           treeBytes, compactTreeBytes(ct));
+    // save the compact tree, then load it back from the binary file and
+    // traverse it where it lies in the mapped file
+    if (!saveCompactTree(ct, BINARYFILENAME))
+        printf("Unable to save the compact tree to %s\n", BINARYFILENAME);
+    ct = deleteCompactTree(ct);
+    printf("Allocation count after deleting the compact tree is %d\n", AllocationCount);
+    ct = loadCompactTree(BINARYFILENAME);
+    if (ct == NULL)
+        printf("Unable to load the compact tree from %s\n", BINARYFILENAME);
+    else {
+        printf("\nLoaded %u nodes (%ld bytes) from %s\n", ct -> count, compactTreeBytes(ct), BINARYFILENAME);
+        printf("\nThe loaded in-order traversal is: ");
+        compactTraversal(ct, INORDER);
+        printf("\n\n");
+        ct = deleteCompactTree(ct);
+        printf("Allocation count after deleting the loaded tree is %d\n", AllocationCount);
+    }
     // close the file being read
     fclose(in);
 } // end main
@@ -174,11 +425,10 @@ int main()
 // subtree.
 // It uses recursion to call itself and repeat this process for all existing
 // nodes within the binary tree.
-// Each time a node is created, memory is dynamically allocated
-// for it. AllocationCount is increased to reflect the dynamically
-// allocated memory. It returns the node which gets created and assigned
-// a name.
-TreeNodePtr buildTree   (FILE * in, TreeNodePtr nodeParent)
+// Each time a node is created, memory for it is taken from the node
+// arena, which updates AllocationCount whenever it allocates a new slab.
+// It returns the node which gets created and assigned a name.
+TreeNodePtr buildTree   (FILE * in, TreeNodePtr nodeParent, NodeArena nodes)
 {
     // initialize a string variable to hold MaxWordSize number of
     // characters (20) and a NULL (zero byte) at the end
@@ -189,44 +439,657 @@ TreeNodePtr buildTree   (FILE * in, TreeNodePtr nodeParent)
     // but is an "@" character
     // i.e. NULL
     if (strcmp(str, "@") == 0) return NULL;
-    // allocate memory for the node
-    TreeNodePtr p = (TreeNodePtr) malloc(sizeof(TreeNode));
-    // increase AllocationCount to reflect the newly created memory
-    AllocationCount++;
+    // allocate memory for the node from the arena
+    TreeNodePtr p = (TreeNodePtr) arenaAlloc(nodes);
     // set the node's name, or struct item called "word"
     strcpy(p -> data.word, str);
     // set the node's parent, or node which resides above it
     p -> parent = nodeParent;
     // set the node's left subtree node
-    p -> left = buildTree(in, p);
+    p -> left = buildTree(in, p, nodes);
     // set the node's right subtree node
-    p -> right = buildTree(in, p);
+    p -> right = buildTree(in, p, nodes);
     // return the node who's information was
     // just set
     return p;
 } //end buildTree
 
- // deleteTree() uses recursion to search the tree, delete and free up all of its nodes
+// buildTreeIterative takes an opened file and a node arena as its arguments.
+// It reads the same preorder list of names and "@" characters as
+// buildTree and builds the same tree with the same parent links.
+// Instead of calling itself for the left and then the right subtree,
+// it keeps a stack of the links still waiting for a node. The root link
+// starts on the stack. Each word read fills in the link on top of the
+// stack: "@" leaves it NULL, while a name creates a node and pushes the
+// new node's right link and then its left link, so the left subtree is
+// read first just as buildTree does. Links still waiting when the file
+// runs out are left NULL.
+// The nodes are allocated from the arena. The stack and the TokenReader
+// are dynamically allocated and freed before returning.
+// Because words are read a buffer at a time, the file may have been read
+// past the end of the tree when this function returns.
+TreeNodePtr buildTreeIterative (FILE * in, NodeArena nodes)
+{
+    // the tree is empty until the root link is filled in
+    TreeNodePtr root = NULL;
+    // initialize a string variable to hold MaxWordSize number of
+    // characters (20) and a NULL (zero byte) at the end
+    char str[MaxWordSize+1];
+    // allocate the reader that buffers the file and the stack
+    int stackSize = INITIALSTACKSIZE;
+    TokenReader * reader = (TokenReader *) malloc(sizeof(TokenReader));
+    PendingLink * stack = (PendingLink *) malloc(stackSize * sizeof(PendingLink));
+    if ((reader == NULL) || (stack == NULL)) {
+        printf ("Unable to allocate memory to build the tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount += 2;
+    reader -> in = in;
+    reader -> next = 0;
+    reader -> end = 0;
+    // push the root link, which has no parent
+    int top = 0;
+    stack[top].link = &root;
+    stack[top].parent = NULL;
+    top++;
+    // fill in links until none are waiting or the words run out
+    while ((top > 0) && nextToken(reader, str)) {
+        // take the link on top of the stack
+        PendingLink pending = stack[--top];
+        // an "@" character means this link stays NULL
+        if (strcmp(str, "@") == 0) continue;
+        // allocate memory for the node from the arena
+        TreeNodePtr p = (TreeNodePtr) arenaAlloc(nodes);
+        // set the node's name, its parent and, until they are read,
+        // empty subtrees
+        strcpy(p -> data.word, str);
+        p -> parent = pending.parent;
+        p -> left = NULL;
+        p -> right = NULL;
+        // link the node in where it was waited for
+        *pending.link = p;
+        // make room for two more links; the new stack replaces the old
+        // one, so AllocationCount is unchanged
+        if (top + 2 > stackSize) {
+            stackSize *= 2;
+            stack = (PendingLink *) realloc(stack, stackSize * sizeof(PendingLink));
+            if (stack == NULL) {
+                printf ("Unable to allocate memory to build the tree... exiting\n");
+                exit (0);
+            }
+        }
+        // push the right link first so the left link is filled in next
+        stack[top].link = &p -> right;
+        stack[top].parent = p;
+        top++;
+        stack[top].link = &p -> left;
+        stack[top].parent = p;
+        top++;
+    }
+    // free the stack and the reader, decreasing AllocationCount
+    free(stack);
+    free(reader);
+    AllocationCount -= 2;
+    // return the root node
+    return root;
+} //end buildTreeIterative
+
+// nextToken takes a TokenReader and a char array as arguments.
+// It skips any white space and then copies the characters up to the next
+// white space (or the end of the file) into the array, keeping only the
+// first MaxWordSize of a longer word. Whenever the buffer has been used
+// up, the next TOKENBUFFERSIZE bytes are read from the file with one
+// fread() call.
+// It returns 1 if a word was found and 0 at the end of the file.
+int nextToken (TokenReader * reader, char word[])
+{
+    // the number of characters kept and the number seen in this word
+    int length = 0;
+    int seen = 0;
+    while (1) {
+        // refill the buffer once all of it has been used
+        if (reader -> next == reader -> end) {
+            reader -> end = (int) fread(reader -> buffer, 1, TOKENBUFFERSIZE, reader -> in);
+            reader -> next = 0;
+            // stop at the end of the file
+            if (reader -> end == 0) break;
+        }
+        char c = reader -> buffer[reader -> next];
+        // white space ends a word, or is skipped before one starts
+        if (isspace((unsigned char) c)) {
+            if (seen > 0) break;
+            reader -> next++;
+            continue;
+        }
+        // keep the character if there is room for it
+        if (length < MaxWordSize) word[length++] = c;
+        seen++;
+        reader -> next++;
+    }
+    // end the string with a NULL (zero byte)
+    word[length] = '\0';
+    return (seen > 0);
+} //end nextToken
+
+ // deleteTree() takes a binary tree and frees all of its nodes by deleting
+ // the node arena they came from, which costs one free() per slab rather
+ // than one per node and needs no walk of the tree. When verbose is not 0
+ // the nodes are listed first, which does walk the tree.
+ // The tree's root and arena are set to NULL to reflect that the binary
+ // tree no longer exists. It returns nothing
+void deleteTree(BinaryTree * bt, int verbose)
+{
+    // list the nodes in the order they used to be freed one at a time
+    if (verbose) printFreedNodes(bt->root);
+    // free every node at once
+    bt->nodes = deleteNodeArena(bt->nodes);
+    bt->root = NULL;
+}
+
+ // printFreedNodes() lists the nodes of a tree in post-order,
+ // as each one is about to be freed
  // It returns nothing
-void deleteTree(TreeNodePtr rootNode)
+void printFreedNodes(TreeNodePtr rootNode)
 {
-    // check if binary tree node is not NULL
-    if (rootNode != NULL) {
-        // delete node's left subtree
-        deleteTree(rootNode->left);
-        // delete node's right subtree
-        deleteTree(rootNode->right);
-        // display which node will be deleted and freed
+    // step through the tree in post-order
+    TreeIterator it;
+    initIterator(&it, rootNode, POSTORDER);
+    TreeNodePtr nodeP;
+    while ((nodeP = nextNode(&it)) != NULL) {
+        // display which node will be freed
         printf("Node ");
-        visit(rootNode);
+        visit(nodeP);
         printf("has been freed\n");
-        // delete and free the selected node
-        free(rootNode);
-        // decrease AllocationCount to reflect the freed memory
-        AllocationCount--;
     }
 }
 
+// initIterator takes an iterator, the root of the tree to traverse and the
+// order to traverse it in. The first node of a pre-order traversal is the
+// root, of an in-order traversal the leftmost node and of a post-order
+// traversal the first leaf found going left whenever possible.
+// It returns nothing
+void initIterator(TreeIterator * it, TreeNodePtr root, TraversalOrder order)
+{
+    it -> order = order;
+    it -> root = root;
+    it -> next = root;
+    // an empty tree has nothing to traverse
+    if (root == NULL) return;
+    if (order == INORDER) {
+        // go as far left as possible
+        while (it -> next -> left != NULL) it -> next = it -> next -> left;
+    } else if (order == POSTORDER)
+        it -> next = firstPostOrder(root);
+} //end initIterator
+
+// nextNode takes an iterator and returns the node it was going to return
+// next, after working out the node to follow it from the parent links:
+//  - pre-order goes down to the left child, or else the right child. A
+//    leaf climbs until it comes up from a left child whose parent has a
+//    right child, and that right child is next.
+//  - in-order goes to the leftmost node of the right subtree. Without a
+//    right subtree it climbs until it comes up from a left child, and
+//    that parent is next.
+//  - post-order goes to the parent once both of the parent's subtrees are
+//    done. Coming up from a left child whose parent has a right child,
+//    the first post-order node of that right subtree is next.
+// Climbing stops at the iterator's root, which ends the traversal.
+// Each step uses only the current node, so the iterator can be put aside
+// and continued later.
+// It returns NULL once every node has been returned
+TreeNodePtr nextNode(TreeIterator * it)
+{
+    // current is the node being returned
+    TreeNodePtr current = it -> next;
+    if (current == NULL) return NULL;
+    // nodeP is used to find the following node
+    TreeNodePtr nodeP = current;
+    if (it -> order == PREORDER) {
+        if (nodeP -> left != NULL) it -> next = nodeP -> left;
+        else if (nodeP -> right != NULL) it -> next = nodeP -> right;
+        else {
+            // climb until there is a right subtree still to visit
+            it -> next = NULL;
+            while (nodeP != it -> root) {
+                TreeNodePtr parent = nodeP -> parent;
+                if ((parent -> left == nodeP) && (parent -> right != NULL)) {
+                    it -> next = parent -> right;
+                    break;
+                }
+                nodeP = parent;
+            }
+        }
+    } else if (it -> order == INORDER) {
+        if ((nodeP -> right != NULL)) {
+            // the leftmost node of the right subtree
+            nodeP = nodeP -> right;
+            while (nodeP -> left != NULL) nodeP = nodeP -> left;
+            it -> next = nodeP;
+        } else {
+            // climb until we come up from a left child
+            it -> next = NULL;
+            while (nodeP != it -> root) {
+                TreeNodePtr parent = nodeP -> parent;
+                if (parent -> left == nodeP) {
+                    it -> next = parent;
+                    break;
+                }
+                nodeP = parent;
+            }
+        }
+    } else {
+        // the root is the last node of a post-order traversal
+        if (nodeP == it -> root) it -> next = NULL;
+        else {
+            TreeNodePtr parent = nodeP -> parent;
+            if ((parent -> left == nodeP) && (parent -> right != NULL))
+                it -> next = firstPostOrder(parent -> right);
+            else
+                it -> next = parent;
+        }
+    }
+    return current;
+} //end nextNode
+
+// firstPostOrder takes a node and goes down from it, left when there is a
+// left child and otherwise right, until it reaches a leaf
+// It returns that leaf
+TreeNodePtr firstPostOrder(TreeNodePtr nodeP)
+{
+    while ((nodeP -> left != NULL) || (nodeP -> right != NULL))
+        nodeP = (nodeP -> left != NULL) ? nodeP -> left : nodeP -> right;
+    return nodeP;
+} //end firstPostOrder
+
+// buildCompactTree reads the file the way buildTreeIterative does, with a
+// stack of the links still waiting for a node.  Nodes are added to the end
+// of the compact tree's array, so their indexes are in pre-order and a
+// link is recorded as the index of the node waiting for it and which side
+// it is on (an index stays the same when the array is moved as it grows,
+// where a pointer into it would not).
+// The stack and the TokenReader are dynamically allocated and freed
+// before returning.  It returns the compact tree
+CompactTree buildCompactTree(FILE * in)
+{
+    // initialize a string variable to hold MaxWordSize number of
+    // characters (20) and a NULL (zero byte) at the end
+    char str[MaxWordSize+1];
+    // allocate the compact tree, its node array and its string pool
+    CompactTree ct = (CompactTree) malloc(sizeof(CompactTreeInfo));
+    if (ct == NULL) {
+        printf ("Unable to allocate memory to build the compact tree... exiting\n");
+        exit (0);
+    }
+    ct -> capacity = INITIALCOMPACTNODES;
+    ct -> nodes = (CompactNode *) malloc(ct -> capacity * sizeof(CompactNode));
+    if (ct -> nodes == NULL) {
+        printf ("Unable to allocate memory to build the compact tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount += 2;
+    ct -> count = 0;
+    ct -> root = NOINDEX;
+    ct -> words = initStringPool();
+    ct -> mapping = NULL;
+    // allocate the reader that buffers the file and the stack
+    int stackSize = INITIALSTACKSIZE;
+    TokenReader * reader = (TokenReader *) malloc(sizeof(TokenReader));
+    PendingIndex * stack = (PendingIndex *) malloc(stackSize * sizeof(PendingIndex));
+    if ((reader == NULL) || (stack == NULL)) {
+        printf ("Unable to allocate memory to build the compact tree... exiting\n");
+        exit (0);
+    }
+    AllocationCount += 2;
+    reader -> in = in;
+    reader -> next = 0;
+    reader -> end = 0;
+    // push the root link, which has no parent
+    int top = 0;
+    stack[top].parent = NOINDEX;
+    stack[top].right = 0;
+    top++;
+    // fill in links until none are waiting or the words run out
+    while ((top > 0) && nextToken(reader, str)) {
+        // take the link on top of the stack
+        PendingIndex pending = stack[--top];
+        // an "@" character means this link stays empty
+        if (strcmp(str, "@") == 0) continue;
+        // add the node and link it in where it was waited for
+        uint32_t p = addCompactNode(ct, str, pending.parent);
+        if (pending.parent == NOINDEX) ct -> root = p;
+        else if (pending.right) ct -> nodes[pending.parent].right = p;
+        else ct -> nodes[pending.parent].left = p;
+        // make room for two more links
+        if (top + 2 > stackSize) {
+            stackSize *= 2;
+            stack = (PendingIndex *) realloc(stack, stackSize * sizeof(PendingIndex));
+            if (stack == NULL) {
+                printf ("Unable to allocate memory to build the compact tree... exiting\n");
+                exit (0);
+            }
+        }
+        // push the right link first so the left link is filled in next
+        stack[top].parent = p;
+        stack[top].right = 1;
+        top++;
+        stack[top].parent = p;
+        stack[top].right = 0;
+        top++;
+    }
+    // free the stack and the reader, decreasing AllocationCount
+    free(stack);
+    free(reader);
+    AllocationCount -= 2;
+    return ct;
+} //end buildCompactTree
+
+// addCompactNode doubles the node array if it is full, then fills in the
+// next node with the offset of its interned name, its parent and no
+// children.  It returns the new node's index
+uint32_t addCompactNode(CompactTree ct, const char * word, uint32_t parent)
+{
+    if (ct -> count == ct -> capacity) {
+        ct -> capacity *= 2;
+        ct -> nodes = (CompactNode *) realloc(ct -> nodes, ct -> capacity * sizeof(CompactNode));
+        if (ct -> nodes == NULL) {
+            printf ("Unable to allocate memory to build the compact tree... exiting\n");
+            exit (0);
+        }
+    }
+    uint32_t index = ct -> count++;
+    ct -> nodes[index].word = internString(ct -> words, word);
+    ct -> nodes[index].left = NOINDEX;
+    ct -> nodes[index].right = NOINDEX;
+    ct -> nodes[index].parent = parent;
+    return index;
+} //end addCompactNode
+
+// compactWord looks a node's name up in the string pool, or in the
+// mapped file for a loaded tree
+const char * compactWord(CompactTree ct, uint32_t index)
+{
+    if (ct -> mapping != NULL) return ct -> mappedWords + ct -> nodes[index].word;
+    return poolString(ct -> words, ct -> nodes[index].word);
+} //end compactWord
+
+// initCompactIterator finds the first node of the traversal as
+// initIterator does
+void initCompactIterator(CompactIterator * it, CompactTree ct, TraversalOrder order)
+{
+    it -> order = order;
+    it -> tree = ct;
+    it -> root = ct -> root;
+    it -> next = ct -> root;
+    if (ct -> root == NOINDEX) return;
+    if (order == INORDER) {
+        while (ct -> nodes[it -> next].left != NOINDEX) it -> next = ct -> nodes[it -> next].left;
+    } else if (order == POSTORDER)
+        it -> next = firstCompactPostOrder(ct, ct -> root);
+} //end initCompactIterator
+
+// nextCompactNode follows the same steps as nextNode, with indexes in
+// place of pointers
+uint32_t nextCompactNode(CompactIterator * it)
+{
+    CompactNode * nodes = it -> tree -> nodes;
+    uint32_t current = it -> next;
+    if (current == NOINDEX) return NOINDEX;
+    uint32_t index = current;
+    if (it -> order == PREORDER) {
+        if (nodes[index].left != NOINDEX) it -> next = nodes[index].left;
+        else if (nodes[index].right != NOINDEX) it -> next = nodes[index].right;
+        else {
+            it -> next = NOINDEX;
+            while (index != it -> root) {
+                uint32_t parent = nodes[index].parent;
+                if ((nodes[parent].left == index) && (nodes[parent].right != NOINDEX)) {
+                    it -> next = nodes[parent].right;
+                    break;
+                }
+                index = parent;
+            }
+        }
+    } else if (it -> order == INORDER) {
+        if (nodes[index].right != NOINDEX) {
+            index = nodes[index].right;
+            while (nodes[index].left != NOINDEX) index = nodes[index].left;
+            it -> next = index;
+        } else {
+            it -> next = NOINDEX;
+            while (index != it -> root) {
+                uint32_t parent = nodes[index].parent;
+                if (nodes[parent].left == index) {
+                    it -> next = parent;
+                    break;
+                }
+                index = parent;
+            }
+        }
+    } else {
+        if (index == it -> root) it -> next = NOINDEX;
+        else {
+            uint32_t parent = nodes[index].parent;
+            if ((nodes[parent].left == index) && (nodes[parent].right != NOINDEX))
+                it -> next = firstCompactPostOrder(it -> tree, nodes[parent].right);
+            else
+                it -> next = parent;
+        }
+    }
+    return current;
+} //end nextCompactNode
+
+// firstCompactPostOrder goes down as firstPostOrder does
+uint32_t firstCompactPostOrder(CompactTree ct, uint32_t index)
+{
+    while ((ct -> nodes[index].left != NOINDEX) || (ct -> nodes[index].right != NOINDEX))
+        index = (ct -> nodes[index].left != NOINDEX) ? ct -> nodes[index].left : ct -> nodes[index].right;
+    return index;
+} //end firstCompactPostOrder
+
+// compactTraversal prints each node's name as visit does
+void compactTraversal(CompactTree ct, TraversalOrder order)
+{
+    CompactIterator it;
+    initCompactIterator(&it, ct, order);
+    uint32_t index;
+    while ((index = nextCompactNode(&it)) != NOINDEX)
+        printf("%s ", compactWord(ct, index));
+} //end compactTraversal
+
+// compactNodeDump prints each node in post-order as dumpNode does: its
+// name, then the names of its parent, children and siblings, or * for any
+// that do not exist
+void compactNodeDump(CompactTree ct)
+{
+    CompactNode * nodes = ct -> nodes;
+    CompactIterator it;
+    initCompactIterator(&it, ct, POSTORDER);
+    uint32_t index;
+    while ((index = nextCompactNode(&it)) != NOINDEX) {
+        uint32_t parent = nodes[index].parent;
+        // the names of the related nodes, NOINDEX where there is none
+        uint32_t related[5];
+        related[0] = parent;
+        related[1] = nodes[index].left;
+        related[2] = nodes[index].right;
+        related[3] = related[4] = NOINDEX;
+        if ((parent != NOINDEX) && (nodes[parent].left != index)) related[3] = nodes[parent].left;
+        if ((parent != NOINDEX) && (nodes[parent].right != index)) related[4] = nodes[parent].right;
+        printf("%s \t", compactWord(ct, index));
+        for (int i = 0; i < 5; i++) {
+            if (related[i] != NOINDEX) printf("%s ", compactWord(ct, related[i]));
+            else printf("* ");
+            printf((i < 4) ? "\t" : "\n");
+        }
+    }
+} //end compactNodeDump
+
+// compactTreeBytes adds the memory of the nodes in use to the memory of
+// the string pool
+long compactTreeBytes(CompactTree ct)
+{
+    if (ct -> mapping != NULL) return (long) ct -> mappingSize;
+    return (long) ct -> count * (long) sizeof(CompactNode) + stringPoolBytes(ct -> words);
+} //end compactTreeBytes
+
+// deleteCompactTree frees the string pool, the node array and the tree.
+// For a loaded tree it unmaps the file instead of freeing the pool and
+// the nodes
+CompactTree deleteCompactTree(CompactTree ct)
+{
+    if (ct -> mapping != NULL) {
+#ifdef _WIN32
+        free(ct -> mapping);
+#else
+        munmap(ct -> mapping, ct -> mappingSize);
+#endif
+    } else {
+        ct -> words = deleteStringPool(ct -> words);
+        free(ct -> nodes);
+    }
+    free(ct);
+    AllocationCount -= 2;
+    return NULL;
+} //end deleteCompactTree
+
+// saveCompactTree fills in a header and writes it, the nodes in use and
+// the characters of the names to the file, each with one fwrite() call.
+// It returns 1 if everything was written and 0 otherwise
+int saveCompactTree(CompactTree ct, const char * filename)
+{
+    CompactFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COMPACTMAGIC, 4);
+    header.version = COMPACTVERSION;
+    header.count = ct -> count;
+    header.root = ct -> root;
+    // a loaded tree can be saved again from its mapped names
+    const char * words = (ct -> mapping != NULL) ? ct -> mappedWords : ct -> words -> chars;
+    header.wordsLength = (ct -> mapping != NULL) ? ct -> mappedLength : ct -> words -> length;
+
+    FILE * out = fopen(filename, "wb");
+    if (out == NULL) return 0;
+    int written = (fwrite(&header, sizeof(header), 1, out) == 1) &&
+                  (fwrite(ct -> nodes, sizeof(CompactNode), ct -> count, out) == ct -> count) &&
+                  (fwrite(words, 1, header.wordsLength, out) == header.wordsLength);
+    if (fclose(out) != 0) written = 0;
+    return written;
+} //end saveCompactTree
+
+// loadCompactTree finds the file's size, maps the whole file into memory
+// for reading and checks the header: the magic characters and version must
+// match and the file must be exactly the size the header says, ending with
+// the NULL (zero byte) of the last name.  The tree's nodes and names then
+// point into the mapped file, and checkCompactTree checks every node, so
+// that a damaged or made up file is turned away here rather than being
+// read past its end (or walked round in circles) later.  That reads the
+// whole file once.  The mapping and the tree are counted in AllocationCount.
+// It returns NULL if the file cannot be used
+CompactTree loadCompactTree(const char * filename)
+{
+    FILE * in = fopen(filename, "rb");
+    if (in == NULL) return NULL;
+    void * mapping = NULL;
+    size_t size = 0;
+#ifdef _WIN32
+    // without mmap(), read the whole file into memory
+    if (fseek(in, 0, SEEK_END) == 0) {
+        long end = ftell(in);
+        if ((end > 0) && (fseek(in, 0, SEEK_SET) == 0)) {
+            size = (size_t) end;
+            mapping = malloc(size);
+            if ((mapping != NULL) && (fread(mapping, 1, size, in) != size)) {
+                free(mapping);
+                mapping = NULL;
+            }
+        }
+    }
+#else
+    struct stat status;
+    if ((fstat(fileno(in), &status) == 0) && (status.st_size > 0)) {
+        size = (size_t) status.st_size;
+        mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(in), 0);
+        if (mapping == MAP_FAILED) mapping = NULL;
+    }
+#endif
+    // the mapping stays valid once the file is closed
+    fclose(in);
+    if (mapping == NULL) return NULL;
+
+    // check the header against the file's size
+    CompactFileHeader * header = (CompactFileHeader *) mapping;
+    size_t nodesSize = 0;
+    int valid = (size >= sizeof(CompactFileHeader)) &&
+                (memcmp(header -> magic, COMPACTMAGIC, 4) == 0) &&
+                (header -> version == COMPACTVERSION);
+    if (valid) {
+        nodesSize = (size_t) header -> count * sizeof(CompactNode);
+        valid = (size == sizeof(CompactFileHeader) + nodesSize + header -> wordsLength) &&
+                ((header -> root == NOINDEX) ? (header -> count == 0) : (header -> root < header -> count)) &&
+                ((header -> wordsLength == 0) || (((char *) mapping)[size - 1] == '\0'));
+    }
+    CompactTree ct = valid ? (CompactTree) malloc(sizeof(CompactTreeInfo)) : NULL;
+    if (ct == NULL) {
+#ifdef _WIN32
+        free(mapping);
+#else
+        munmap(mapping, size);
+#endif
+        return NULL;
+    }
+    AllocationCount += 2;
+    ct -> nodes = (CompactNode *) ((char *) mapping + sizeof(CompactFileHeader));
+    ct -> count = header -> count;
+    ct -> capacity = header -> count;
+    ct -> root = header -> root;
+    ct -> words = NULL;
+    ct -> mapping = mapping;
+    ct -> mappingSize = size;
+    ct -> mappedWords = (const char *) mapping + sizeof(CompactFileHeader) + nodesSize;
+    ct -> mappedLength = header -> wordsLength;
+    if (!checkCompactTree(ct)) ct = deleteCompactTree(ct);
+    return ct;
+} //end loadCompactTree
+
+// checkCompactTree first checks each node on its own: its name must start
+// inside the names (which end with a NULL, so the name does too) and each
+// link must be NOINDEX or the index of a node.  Then each child must point
+// back at the node as its parent, so no node is the child of two nodes or
+// twice the child of one, and every node but the root must have a parent
+// that has it as a child.  Then only the root has no parent and every other
+// node has exactly one, so a walk down from the root cannot go round in a
+// circle.  The walk must reach every node, or some nodes form a loop of
+// their own away from the root
+int checkCompactTree(CompactTree ct)
+{
+    CompactNode * nodes = ct -> nodes;
+    for (uint32_t i = 0; i < ct -> count; i++) {
+        CompactNode node = nodes[i];
+        if ((node.word >= ct -> mappedLength) ||
+            ((node.left != NOINDEX) && (node.left >= ct -> count)) ||
+            ((node.right != NOINDEX) && (node.right >= ct -> count)) ||
+            ((node.parent != NOINDEX) && (node.parent >= ct -> count)))
+            return 0;
+    }
+    for (uint32_t i = 0; i < ct -> count; i++) {
+        CompactNode node = nodes[i];
+        if ((node.left != NOINDEX) && ((node.left == node.right) || (nodes[node.left].parent != i)))
+            return 0;
+        if ((node.right != NOINDEX) && (nodes[node.right].parent != i))
+            return 0;
+        if (i == ct -> root) {
+            if (node.parent != NOINDEX) return 0;
+        } else if ((node.parent == NOINDEX) ||
+                   ((nodes[node.parent].left != i) && (nodes[node.parent].right != i)))
+            return 0;
+    }
+    CompactIterator it;
+    initCompactIterator(&it, ct, PREORDER);
+    uint32_t reached = 0;
+    while (nextCompactNode(&it) != NOINDEX) reached++;
+    return reached == ct -> count;
+} //end checkCompactTree
+
 // Print and display a node's name, a letter,
 // that takes the binary tree's root node as an argument
 // It returns nothing
@@ -241,118 +1104,105 @@ void visit(TreeNodePtr nodeP)
 // First visit the root node, then the left subtree and finally the right subtree.
 // Every node may represent a subtree itself.
 // It returns nothing.
-// It uses a recursive routine to call itself to traverse the tree via pre-order method
-// and call visit() to print and display each currently
+// It uses a TreeIterator to traverse the tree via pre-order method
+// and calls visit() to print and display each currently
 // looked at node's name
 void preOrder(TreeNodePtr nodeP)
 {
-    // check that the node exists
-    if (nodeP != NULL) {
-        // print and display the existing node's name
+    // step through the tree in pre-order, printing and
+    // displaying each node's name
+    TreeIterator it;
+    initIterator(&it, nodeP, PREORDER);
+    while ((nodeP = nextNode(&it)) != NULL)
         visit(nodeP);
-        // repeat this function's logic at the left subtree's nodes
-        // using recursion, calling this function again
-        preOrder(nodeP -> left);
-        // repeat this function's logic at the right subtree's nodes
-        // using recursion, calling this function again
-        preOrder(nodeP -> right);
-    }
 } //end preOrder
 
 // In-order traversal of a tree that takes the binary tree's root node as an argument
 // First visit the left subtree, then the root and finally the right subtree.
 // Every node may represent a subtree itself.
 // It returns nothing.
-// It uses a recursive routine to call itself to traverse the tree via in-order method
-// and call visit() to print and display each currently
+// It uses a TreeIterator to traverse the tree via in-order method
+// and calls visit() to print and display each currently
 // looked at node's name
 void inOrder(TreeNodePtr nodeP)
 {
-    // check that the node exists
-    if (nodeP != NULL) {
-        // repeat this function's logic at the left subtree's nodes
-        // using recursion, calling this function again
-        inOrder(nodeP -> left);
-        // print and display the existing node's name
+    // step through the tree in in-order, printing and
+    // displaying each node's name
+    TreeIterator it;
+    initIterator(&it, nodeP, INORDER);
+    while ((nodeP = nextNode(&it)) != NULL)
         visit(nodeP);
-        // repeat this function's logic at the right subtree's nodes
-        // using recursion, calling this function again
-        inOrder(nodeP -> right);
-    }
 } //end inOrder
 
 // Post-order traversal of a tree that takes the binary tree's root node as an argument
 // First visit the left subtree, then the right subtree and finally the root node.
 // Every node may represent a subtree itself.
 // It returns nothing.
-// It uses a recursive routine to call itself to traverse the tree via post-order method
-// and call visit() to print and display each currently
+// It uses a TreeIterator to traverse the tree via post-order method
+// and calls visit() to print and display each currently
 // looked at node's name
 void postOrder(TreeNodePtr nodeP)
 {
-        // check that the node exists
-        if (nodeP != NULL) {
-        // repeat this function's logic at the left subtree's nodes
-        // using recursion, calling this function again
-        postOrder(nodeP -> left);
-        // repeat this function's logic at the right subtree's nodes
-        // using recursion, calling this function again
-        postOrder(nodeP -> right);
-        // print and display the existing node's name
+    // step through the tree in post-order, printing and
+    // displaying each node's name
+    TreeIterator it;
+    initIterator(&it, nodeP, POSTORDER);
+    while ((nodeP = nextNode(&it)) != NULL)
         visit(nodeP);
-    }
 } //end postOrder
 
 // postOrderNodeDump is used to print out
 // a node's name, parent, left and right children and left and right
 // siblings. It takes a node and returns nothing.
 void postOrderNodeDump(TreeNodePtr nodeP){
-    // check that a node exists to print out relevant data
-    if (nodeP != NULL){
-        // repeat this function's logic at the left subtree's nodes
-        // using recursion, calling this function again
-        postOrderNodeDump(nodeP->left);
-        // repeat this function's logic at the right subtree's nodes
-        // using recursion, calling this function again
-        postOrderNodeDump(nodeP->right);
-        // print and display the node's name
-        printf("%s \t", nodeP->data.word);
-        // print and display the node's parent's name, or *
-        // A node has a parent if its parent link is not NULL. The parent node name can be
-        // accessed by going through the parent link
-        if (nodeP->parent != NULL) {
-            printf("%s \t", nodeP->parent->data.word);
-        } else
-            printf("* \t");
-        // print and display the node's left child's name, or *
-        // A node has a left child if its left link is not NULL. The left child node name can be
-        // accessed by going through the left link
-        if (nodeP->left != NULL) {
-            printf("%s \t", nodeP->left->data.word);
-        } else
-            printf("* \t");
-        // print and display the node's right child's name, or *
-        // A node has a right child if its right link is not NULL. The right child node name
-        // can be accessed by going through the right link
-        if (nodeP->right != NULL) {
-            printf("%s \t", nodeP->right->data.word);
-        } else
-            printf("* \t");
-        // print and display the node's left sibling's name, or *
-        // A node has a left sibling if the node (a) has a parent and (b) the parent's left child
-        // exists and (c) the left child is not the same link as our node
-        if ((nodeP->parent != NULL) && (nodeP->parent->left != NULL) &&
-            (nodeP->parent->left != nodeP)) {
-            printf("%s \t", nodeP->parent->left->data.word);
-        } else
-            printf("* \t");
-        // print and display the node's right sibling's name, or *
-        // A node has a right sibling if the node (a) has a parent and (b) the parent's right
-        // child exists and (c) the right child is not the same link as our node
-        if ((nodeP->parent != NULL) && (nodeP->parent->right != NULL) &&
-            (nodeP->parent->right != nodeP)) {
-            printf("%s \n", nodeP->parent->right->data.word);
-        } else
-            printf("* \n");
-    }
+    // step through the tree in post-order, dumping each node
+    TreeIterator it;
+    initIterator(&it, nodeP, POSTORDER);
+    while ((nodeP = nextNode(&it)) != NULL)
+        dumpNode(nodeP);
 }
+
+// dumpNode prints and displays a node's name, parent, left and right
+// children and left and right siblings on one line, with * for any
+// that do not exist. It takes a node and returns nothing.
+void dumpNode(TreeNodePtr nodeP){
+    // print and display the node's name
+    printf("%s \t", nodeP->data.word);
+    // print and display the node's parent's name, or *
+    // A node has a parent if its parent link is not NULL. The parent node name can be
+    // accessed by going through the parent link
+    if (nodeP->parent != NULL) {
+        printf("%s \t", nodeP->parent->data.word);
+    } else
+        printf("* \t");
+    // print and display the node's left child's name, or *
+    // A node has a left child if its left link is not NULL. The left child node name can be
+    // accessed by going through the left link
+    if (nodeP->left != NULL) {
+        printf("%s \t", nodeP->left->data.word);
+    } else
+        printf("* \t");
+    // print and display the node's right child's name, or *
+    // A node has a right child if its right link is not NULL. The right child node name
+    // can be accessed by going through the right link
+    if (nodeP->right != NULL) {
+        printf("%s \t", nodeP->right->data.word);
+    } else
+        printf("* \t");
+    // print and display the node's left sibling's name, or *
+    // A node has a left sibling if the node (a) has a parent and (b) the parent's left child
+    // exists and (c) the left child is not the same link as our node
+    if ((nodeP->parent != NULL) && (nodeP->parent->left != NULL) &&
+        (nodeP->parent->left != nodeP)) {
+        printf("%s \t", nodeP->parent->left->data.word);
+    } else
+        printf("* \t");
+    // print and display the node's right sibling's name, or *
+    // A node has a right sibling if the node (a) has a parent and (b) the parent's right
+    // child exists and (c) the right child is not the same link as our node
+    if ((nodeP->parent != NULL) && (nodeP->parent->right != NULL) &&
+        (nodeP->parent->right != nodeP)) {
+        printf("%s \n", nodeP->parent->right->data.word);
+    } else
+        printf("* \n");
+} //end dumpNode
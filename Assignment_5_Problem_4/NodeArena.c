@@ -0,0 +1,124 @@
+// NodeArena.c allocates fixed size items from slabs of memory.
+//
+// Each slab is one malloc() holding an ArenaSlab header followed by
+// room for its items. Items are handed out from the newest slab in
+// order; when it is full a new slab is allocated and put at the front of
+// the list. Deleting the arena walks the list of slabs, so its cost
+// depends on the number of slabs, not the number of items.
+
+// printf provides the error message when memory runs out
+#include <stdio.h>
+// stdlib provides malloc(), free() and exit()
+#include <stdlib.h>
+// the arena's own declarations are included for consistency checking
+#include "NodeArena.h"
+
+// ARENAALIGNMENT is the number of bytes every item's size (and the slab
+// header's size) is rounded up to, so that any kind of data can be stored
+// in an item
+#define ARENAALIGNMENT 16
+
+// To make sure we are allocating and deallocating dynamic memory,
+// AllocationCount (defined with main) is updated for each slab and for
+// the arena itself
+extern int AllocationCount;
+
+// roundUp is a local function that rounds a size up to a multiple of
+// ARENAALIGNMENT
+static size_t roundUp (size_t size);
+// newSlab is a local function that allocates a slab, links it at the
+// front of the arena's slab list and returns it
+static ArenaSlab * newSlab (NodeArena arena);
+
+// initNodeArena allocates the arena and records the item size and slab
+// size. No slab is allocated until the first item is asked for
+NodeArena initNodeArena (size_t itemSize, int itemsPerSlab)
+{
+    NodeArena arena = (NodeArena) malloc(sizeof(NodeArenaInfo));
+    if ((arena == NULL) || (itemSize == 0) || (itemsPerSlab < 1)) {
+        printf ("Unable to create a node arena... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    arena -> itemSize = roundUp(itemSize);
+    arena -> itemsPerSlab = (size_t) itemsPerSlab;
+    arena -> slabs = NULL;
+    arena -> numSlabs = 0;
+    arena -> numItems = 0;
+    return arena;
+} // end initNodeArena
+
+// arenaAlloc takes the next unused item of the newest slab, first
+// allocating a new slab if there is none or it is full. The items of a
+// slab start just after its (rounded up) header
+void * arenaAlloc (NodeArena arena)
+{
+    ArenaSlab * slab = arena -> slabs;
+    if ((slab == NULL) || (slab -> used == slab -> capacity))
+        slab = newSlab(arena);
+    char * item = (char *) slab + roundUp(sizeof(ArenaSlab)) + slab -> used * arena -> itemSize;
+    slab -> used++;
+    arena -> numItems++;
+    return item;
+} // end arenaAlloc
+
+// arenaItems returns the count of items handed out
+long arenaItems (NodeArena arena)
+{
+    return arena -> numItems;
+} // end arenaItems
+
+// resetNodeArena frees all slabs but the newest and marks that one empty
+void resetNodeArena (NodeArena arena)
+{
+    if (arena -> slabs == NULL) return;
+    ArenaSlab * slab = arena -> slabs -> next;
+    while (slab != NULL) {
+        ArenaSlab * next = slab -> next;
+        free(slab);
+        AllocationCount--;
+        slab = next;
+    }
+    arena -> slabs -> next = NULL;
+    arena -> slabs -> used = 0;
+    arena -> numSlabs = 1;
+    arena -> numItems = 0;
+} // end resetNodeArena
+
+// deleteNodeArena frees each slab and then the arena
+NodeArena deleteNodeArena (NodeArena arena)
+{
+    ArenaSlab * slab = arena -> slabs;
+    while (slab != NULL) {
+        ArenaSlab * next = slab -> next;
+        free(slab);
+        AllocationCount--;
+        slab = next;
+    }
+    free(arena);
+    AllocationCount--;
+    return NULL;
+} // end deleteNodeArena
+
+// roundUp adds one less than ARENAALIGNMENT and then drops the remainder
+size_t roundUp (size_t size)
+{
+    return (size + ARENAALIGNMENT - 1) / ARENAALIGNMENT * ARENAALIGNMENT;
+} // end roundUp
+
+// newSlab allocates room for the header and itemsPerSlab items in one block
+ArenaSlab * newSlab (NodeArena arena)
+{
+    ArenaSlab * slab = (ArenaSlab *) malloc(roundUp(sizeof(ArenaSlab)) + arena -> itemsPerSlab * arena -> itemSize);
+    if (slab == NULL) {
+        printf ("Unable to allocate memory for the node arena... exiting\n");
+        exit (0);
+    }
+    AllocationCount++;
+    slab -> used = 0;
+    slab -> capacity = arena -> itemsPerSlab;
+    slab -> next = arena -> slabs;
+    arena -> slabs = slab;
+    arena -> numSlabs++;
+    return slab;
+} // end newSlab
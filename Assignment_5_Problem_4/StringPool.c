@@ -0,0 +1,151 @@
+// StringPool.c stores each different string once and finds it again by
+// hashing.
+//
+// The hash table uses open addressing: a string goes in the slot its hash
+// picks or, if that slot is taken by another string, the next free slot
+// after it. The table is doubled once it is half full. The characters are
+// kept in a block that is doubled when it runs out of room, so offsets
+// stay valid as the pool grows (pointers returned by poolString do not).
+
+// printf provides the error message when memory runs out
+#include <stdio.h>
+// stdlib provides malloc(), realloc(), calloc(), free() and exit()
+#include <stdlib.h>
+// string.h provides strlen(), strcmp() and memcpy()
+#include <string.h>
+// the pool's own declarations are included for consistency checking
+#include "StringPool.h"
+
+// INITIALPOOLSLOTS and INITIALPOOLCHARS are the number of hash table slots
+// and characters an empty pool starts with
+#define INITIALPOOLSLOTS 16
+#define INITIALPOOLCHARS 256
+
+// To make sure we are allocating and deallocating dynamic memory,
+// AllocationCount (defined with main) is updated for the pool, its
+// characters and its hash table
+extern int AllocationCount;
+
+// hashString is a local function that returns the FNV-1a hash of a string
+static uint32_t hashString (const char * string);
+// findSlot is a local function that returns the index of the slot holding
+// the string, or of the empty slot where it belongs
+static uint32_t findSlot (StringPool pool, const char * string, uint32_t hash);
+// growSlots is a local function that doubles the hash table
+static void growSlots (StringPool pool);
+
+// initStringPool allocates the pool, its characters and its hash table
+StringPool initStringPool (void)
+{
+    StringPool pool = (StringPool) malloc(sizeof(StringPoolInfo));
+    if (pool == NULL) {
+        printf ("Unable to create a string pool... exiting\n");
+        exit (0);
+    }
+    pool -> chars = (char *) malloc(INITIALPOOLCHARS);
+    pool -> slots = (uint32_t *) calloc(INITIALPOOLSLOTS, sizeof(uint32_t));
+    if ((pool -> chars == NULL) || (pool -> slots == NULL)) {
+        printf ("Unable to create a string pool... exiting\n");
+        exit (0);
+    }
+    AllocationCount += 3;
+    pool -> length = 0;
+    pool -> capacity = INITIALPOOLCHARS;
+    pool -> numSlots = INITIALPOOLSLOTS;
+    pool -> numStrings = 0;
+    return pool;
+} // end initStringPool
+
+// internString looks the string up in the hash table. If it is new, it is
+// copied to the end of the characters (doubling them if need be) and its
+// offset is recorded in the empty slot that was found
+uint32_t internString (StringPool pool, const char * string)
+{
+    if (2 * (pool -> numStrings + 1) > pool -> numSlots) growSlots(pool);
+    uint32_t hash = hashString(string);
+    uint32_t slot = findSlot(pool, string, hash);
+    if (pool -> slots[slot] != 0) return pool -> slots[slot] - 1;
+
+    uint32_t size = (uint32_t) strlen(string) + 1;
+    while (pool -> length + size > pool -> capacity) {
+        pool -> capacity *= 2;
+        pool -> chars = (char *) realloc(pool -> chars, pool -> capacity);
+        if (pool -> chars == NULL) {
+            printf ("Unable to allocate memory for the string pool... exiting\n");
+            exit (0);
+        }
+    }
+    uint32_t offset = pool -> length;
+    memcpy(pool -> chars + offset, string, size);
+    pool -> length += size;
+    pool -> slots[slot] = offset + 1;
+    pool -> numStrings++;
+    return offset;
+} // end internString
+
+// poolString finds the string at its offset in the characters
+const char * poolString (StringPool pool, uint32_t offset)
+{
+    return pool -> chars + offset;
+} // end poolString
+
+// stringPoolBytes adds the characters in use to the size of the hash table
+long stringPoolBytes (StringPool pool)
+{
+    return (long) pool -> length + (long) pool -> numSlots * (long) sizeof(uint32_t);
+} // end stringPoolBytes
+
+// deleteStringPool frees the characters, the hash table and the pool
+StringPool deleteStringPool (StringPool pool)
+{
+    free(pool -> chars);
+    free(pool -> slots);
+    free(pool);
+    AllocationCount -= 3;
+    return NULL;
+} // end deleteStringPool
+
+// hashString mixes in each character with an exclusive or and then a
+// multiply by the FNV prime
+uint32_t hashString (const char * string)
+{
+    uint32_t hash = 2166136261u;
+    for ( ; *string != '\0'; string++) {
+        hash ^= (unsigned char) *string;
+        hash *= 16777619u;
+    }
+    return hash;
+} // end hashString
+
+// findSlot steps forward (wrapping around at the end) from the slot the
+// hash picks until it finds an empty slot or one holding the string. The
+// table is never more than half full, so an empty slot is always found
+uint32_t findSlot (StringPool pool, const char * string, uint32_t hash)
+{
+    uint32_t mask = pool -> numSlots - 1;
+    uint32_t slot = hash & mask;
+    while ((pool -> slots[slot] != 0) &&
+           (strcmp(pool -> chars + pool -> slots[slot] - 1, string) != 0))
+        slot = (slot + 1) & mask;
+    return slot;
+} // end findSlot
+
+// growSlots swaps in a table twice the size and puts each string's offset
+// back in the slot its hash picks in the new table
+void growSlots (StringPool pool)
+{
+    uint32_t * old = pool -> slots;
+    uint32_t oldSlots = pool -> numSlots;
+    pool -> numSlots *= 2;
+    pool -> slots = (uint32_t *) calloc(pool -> numSlots, sizeof(uint32_t));
+    if (pool -> slots == NULL) {
+        printf ("Unable to allocate memory for the string pool... exiting\n");
+        exit (0);
+    }
+    for (uint32_t i = 0; i < oldSlots; i++)
+        if (old[i] != 0) {
+            const char * string = pool -> chars + old[i] - 1;
+            pool -> slots[findSlot(pool, string, hashString(string))] = old[i];
+        }
+    free(old);
+} // end growSlots
@@ -0,0 +1,42 @@
+#ifndef STRINGPOOL_H_INCLUDED
+#define STRINGPOOL_H_INCLUDED
+
+// A StringPool keeps one copy of each different string it is given
+// (interning). Each string is stored once, with its NULL (zero byte) at the
+// end, in one growing block of characters, and is known by the 32 bit
+// offset where it starts. Adding a string that is already in the pool just
+// returns the offset it already has, so a tree whose nodes repeat the same
+// words only stores each word once and each node only needs the offset.
+// A hash table of offsets finds a string already in the pool.
+
+// uint32_t is defined in stdint.h
+#include <stdint.h>
+
+// StringPoolInfo struct holds the characters of all of the strings, length
+// of the capacity bytes allocated for them being in use, and the hash
+// table: numSlots slots (a power of 2), each 0 if empty or else one more
+// than the offset of a string, numStrings of them in use
+typedef struct {
+    char *chars;
+    uint32_t length;
+    uint32_t capacity;
+    uint32_t *slots;
+    uint32_t numSlots;
+    uint32_t numStrings;
+} StringPoolInfo, *StringPool;
+
+// initStringPool allocates an empty string pool
+StringPool  initStringPool   (void);
+// internString returns the offset of a copy of the string in the pool,
+// adding the string if it is not there yet
+uint32_t    internString     (StringPool pool, const char * string);
+// poolString returns the string at an offset returned by internString
+const char * poolString      (StringPool pool, uint32_t offset);
+// stringPoolBytes returns how many bytes of memory the pool is using for
+// its characters and hash table
+long        stringPoolBytes  (StringPool pool);
+// deleteStringPool frees the pool and all of its strings. It returns NULL
+// to show the pool no longer exists
+StringPool  deleteStringPool (StringPool pool);
+
+#endif // STRINGPOOL_H_INCLUDED
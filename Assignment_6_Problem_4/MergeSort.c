@@ -1,5 +1,6 @@
 #include "UserData.h"
 #include "SortADTs.h"
+#include "WorkStealingPool.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -7,6 +8,21 @@
 static void merge(UserData A[], int lo, int mid, int hi, UserData T[], Comparer ComesFirst);
 static void mergeSort(UserData A[], int lo, int hi, UserData T[], Comparer ComesFirst);
 static void merge(UserData A[], int lo, int mid, int hi, UserData T[], Comparer ComesFirst);
+static void parallelMergeSort(void *Arg);
+
+// PARALLELCUTOFF is the smallest part of the list that ParallelMergeSort
+// splits between tasks; smaller parts are sorted by mergeSort directly
+#define PARALLELCUTOFF 2048
+
+// MergeTask describes the part of the list one task of ParallelMergeSort sorts
+typedef struct {
+    WorkStealingPool Pool;
+    UserData *A;
+    int lo;
+    int hi;
+    UserData *T;
+    Comparer *ComesFirst;
+} MergeTask;
 
 void MergeSort (UserData list[], int ListSize, Comparer ComesFirst)
 {
@@ -20,6 +36,38 @@ void MergeSort (UserData list[], int ListSize, Comparer ComesFirst)
     free (T);
 }
 
+void ParallelMergeSort (WorkStealingPool Pool, UserData list[], int ListSize, Comparer ComesFirst)
+{
+    UserData *T = (UserData *) malloc( sizeof (UserData) * ListSize);
+    if (T == NULL)
+    {
+        printf ("Unable to allocate sufficient space for merge copy.. exiting\n");
+        exit (0);
+    }
+    MergeTask M = {Pool, list, 0, ListSize-1, T, ComesFirst};
+    poolRun (Pool, parallelMergeSort, &M);
+    free (T);
+}
+
+void parallelMergeSort(void *Arg)
+{
+    MergeTask *M = (MergeTask *) Arg;
+    if (M->hi - M->lo < PARALLELCUTOFF)
+    {
+        mergeSort(M->A, M->lo, M->hi, M->T, M->ComesFirst);
+        return;
+    }
+    int mid = (M->lo + M->hi) / 2;
+    MergeTask First = *M, Second = *M;
+    First.hi = mid;
+    Second.lo = mid + 1;
+    PoolTask Task;
+    poolSpawn(M->Pool, &Task, parallelMergeSort, &First); //sort first half in another task
+    parallelMergeSort(&Second); //sort second half here
+    poolSync(M->Pool, &Task);
+    merge(M->A, M->lo, mid, M->hi, M->T, M->ComesFirst); //merge sorted halves
+} //end parallelMergeSort
+
 void mergeSort(UserData A[], int lo, int hi, UserData T[], Comparer ComesFirst)
 {
     if (lo < hi)   //list contains at least 2 elements
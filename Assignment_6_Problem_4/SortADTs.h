@@ -2,6 +2,7 @@
 #define SORTADTS_H_INCLUDED
 
 #include "UserData.h"
+#include "WorkStealingPool.h"
 #include <stdbool.h>
 
 // Comparer is a typedef that gives us a shorthand way of expressing the
@@ -53,6 +54,12 @@ void HeapSort      (UserData list[], int ListSize,   Comparer);
 // to stop sorting.
 void MergeSort     (UserData list[], int ListSize,   Comparer);
 
+// ParallelMergeSort is MergeSort with the two halves of each part of the list sorted at the
+// same time by tasks in the given work-stealing pool, down to parts small enough that
+// splitting them further would cost more than it saves. The merges write to separate parts
+// of one scratch array, so the result is the same as MergeSort's.
+void ParallelMergeSort (WorkStealingPool Pool, UserData list[], int ListSize, Comparer);
+
 // QuickSort is a function for sorting an array by taking a pivot point and moving elements greater
 // to one side while moving elements less than to the other. Then a recursive sort of the left and
 // right sides will leave the entire array sorted. It decides whether to sort by increasing/decreasing
@@ -24,6 +24,11 @@
 #include "UserData.h"
 // declaration of the sort ADT(s) to be called
 #include "SortADTs.h"
+// the pool of threads ParallelMergeSort runs in
+#include "WorkStealingPool.h"
+
+// SORTPOOLWORKERS is the number of threads in the pool used by ParallelMergeSort
+#define SORTPOOLWORKERS 4
 
 /////////////// local function declarations follow ///////////////////
 
@@ -82,6 +87,13 @@ void RunTest (char*             nameOfSort,
               TheSortFunction   TheSort,
               Comparer          SortOrder );
 
+// SortPool is the pool ParallelMergeSort is run in
+static WorkStealingPool SortPool;
+
+// ParallelMergeSortInPool calls ParallelMergeSort with SortPool, so that it can be
+// run through RunTest like the other sorts
+static void ParallelMergeSortInPool (UserData list[], int ListSize, Comparer ComesFirst);
+
 /////////////// local function definitions follow ///////////////////
 
 // ProvideStudentData is a function the user writes that fills the List
@@ -311,8 +323,14 @@ bool HighestGPAFirst (UserData P1, UserData P2)
     return (P1.GPA > P2.GPA);
 }
 
+// ParallelMergeSortInPool passes the list on to ParallelMergeSort, adding the pool
+void ParallelMergeSortInPool (UserData list[], int ListSize, Comparer ComesFirst)
+{
+    ParallelMergeSort (SortPool, list, ListSize, ComesFirst);
+}
+
 // Here is a test main that demonstrates direct sort calls to all 6 of
-// the sorts we are studying for a UserData
+// the sorts we are studying for a UserData, and to the parallel merge sort
 //
 // To just run a sort, you need:
 //   - an array of your UserData, filled in with your data
@@ -353,6 +371,10 @@ int main()
     printf ("==================\n");
     RunTest ("ShellSort Lowest GPA first",       masterArray, scratchArray, numTestItems, ShellSort, LowestGPAFirst);
     printf ("==================\n");
+    SortPool = initWorkStealingPool (SORTPOOLWORKERS);
+    RunTest ("ParallelMergeSort Lowest GPA first",       masterArray, scratchArray, numTestItems, ParallelMergeSortInPool, LowestGPAFirst);
+    SortPool = deleteWorkStealingPool (SortPool);
+    printf ("==================\n");
     return (0);
 } //end main
 
@@ -0,0 +1,350 @@
+// WorkStealingPool.c - a fork-join thread pool with Chase-Lev deques
+//
+// The deque operations follow "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (Le, Pop, Cohen and Zappa Nardelli, 2013).  The
+// owner pushes and takes at Bottom, thieves take at Top, and the only
+// contended step is the compare-and-swap on Top when a thief and the owner
+// go for the last task.
+//
+// Workers with nothing to do sleep on a condition variable.  A spawn
+// wakes one of them only if some are asleep, so a busy pool takes no lock.
+
+#include "WorkStealingPool.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sched.h>
+
+// each worker thread knows its pool and its index in the pool's workers;
+// CurrentPool is NULL in threads that are not workers
+static _Thread_local WorkStealingPool CurrentPool = NULL;
+static _Thread_local int CurrentWorker = -1;
+
+// a parallel for is split in half recursively down to ranges no longer
+// than Grain; a ForRange describes one of those ranges
+typedef struct {
+    WorkStealingPool Pool;
+    int First;
+    int Last;
+    int Grain;
+    PoolRangeFunction *Body;
+    void *Arg;
+} ForRange;
+
+static bool      PushTask   (PoolWorker *W, PoolTask *T);
+static PoolTask *TakeTask   (PoolWorker *W);
+static PoolTask *StealTask  (PoolWorker *W);
+static PoolTask *FindWork   (WorkStealingPool Pool, int Self);
+static bool      AnyWork    (WorkStealingPool Pool);
+static void      RunTask    (PoolTask *T);
+static void     *WorkerLoop (void *Arg);
+static void      RunRange   (void *Arg);
+
+// initWorkStealingPool allocates the pool and its workers and starts a
+// thread for each worker
+WorkStealingPool initWorkStealingPool (int NumWorkers)
+{
+    assert ((NumWorkers > 0) && (NumWorkers <= MAXPOOLWORKERS));
+    WorkStealingPool Pool = (WorkStealingPool) malloc(sizeof(WorkStealingPoolInfo));
+    assert (Pool != NULL);
+    Pool->Workers = (PoolWorker *) malloc(NumWorkers * sizeof(PoolWorker));
+    assert (Pool->Workers != NULL);
+    Pool->NumWorkers = NumWorkers;
+    Pool->Submitted = NULL;
+    atomic_init (&Pool->Sleepers, 0);
+    atomic_init (&Pool->Stopping, false);
+    pthread_mutex_init (&Pool->Lock, NULL);
+    pthread_cond_init (&Pool->WorkSignal, NULL);
+    pthread_cond_init (&Pool->DoneSignal, NULL);
+    for (int i = 0; i < NumWorkers; i++)
+    {
+        PoolWorker *W = &Pool->Workers[i];
+        atomic_init (&W->Top, 0);
+        atomic_init (&W->Bottom, 0);
+        W->Seed = 2654435761u * (i + 1);
+        W->Pool = Pool;
+    }
+    // the workers only start once every deque is ready to be stolen from
+    for (int i = 0; i < NumWorkers; i++)
+    {
+        int result = pthread_create (&Pool->Workers[i].Thread, NULL, WorkerLoop, &Pool->Workers[i]);
+        assert (result == 0);
+        (void) result;
+    }
+    return Pool;
+}
+
+// poolWorkers returns the number of workers
+int poolWorkers (WorkStealingPool Pool)
+{
+    assert (Pool != NULL);
+    return Pool->NumWorkers;
+}
+
+// poolRun adds the task to the Submitted list for an idle worker to pick
+// up and then waits for DoneSignal until the task is done.  A task
+// already running in this pool just calls Run, since it must not sleep
+// while holding up other tasks.
+void poolRun (WorkStealingPool Pool, PoolTaskFunction *Run, void *Arg)
+{
+    assert ((Pool != NULL) && (Run != NULL));
+    if (CurrentPool == Pool)
+    {
+        Run (Arg);
+        return;
+    }
+    PoolTask T;
+    T.Run = Run;
+    T.Arg = Arg;
+    atomic_init (&T.Done, 0);
+    T.next = NULL;
+    pthread_mutex_lock (&Pool->Lock);
+    PoolTask **Link = &Pool->Submitted;
+    while (*Link != NULL)
+        Link = &(*Link)->next;
+    *Link = &T;
+    pthread_cond_signal (&Pool->WorkSignal);
+    while (!atomic_load (&T.Done))
+        pthread_cond_wait (&Pool->DoneSignal, &Pool->Lock);
+    pthread_mutex_unlock (&Pool->Lock);
+}
+
+// poolSpawn pushes the task on the bottom of the calling worker's deque,
+// or runs it at once if the deque is full.  The fence makes the push
+// visible before Sleepers is read, and a sleeping worker counts itself
+// in Sleepers before it looks for work, so either the spawn sees the
+// sleeper and wakes it or the sleeper sees the task.
+void poolSpawn (WorkStealingPool Pool, PoolTask *T, PoolTaskFunction *Run, void *Arg)
+{
+    assert ((Pool != NULL) && (CurrentPool == Pool) && (T != NULL) && (Run != NULL));
+    T->Run = Run;
+    T->Arg = Arg;
+    atomic_store_explicit (&T->Done, 0, memory_order_relaxed);
+    T->next = NULL;
+    if (!PushTask (&Pool->Workers[CurrentWorker], T))
+    {
+        RunTask (T);
+        return;
+    }
+    atomic_thread_fence (memory_order_seq_cst);
+    if (atomic_load_explicit (&Pool->Sleepers, memory_order_relaxed) > 0)
+    {
+        pthread_mutex_lock (&Pool->Lock);
+        pthread_cond_signal (&Pool->WorkSignal);
+        pthread_mutex_unlock (&Pool->Lock);
+    }
+}
+
+// poolSync keeps the worker busy until the task is done.  If the task was
+// not stolen it is the newest task in the worker's own deque, so TakeTask
+// returns it and it runs here.  Otherwise the worker steals and runs
+// other tasks (often ones spawned by the thief) until the thief is done.
+void poolSync (WorkStealingPool Pool, PoolTask *T)
+{
+    assert ((Pool != NULL) && (CurrentPool == Pool) && (T != NULL));
+    PoolWorker *Self = &Pool->Workers[CurrentWorker];
+    while (!atomic_load_explicit (&T->Done, memory_order_acquire))
+    {
+        PoolTask *Next = TakeTask (Self);
+        if (Next == NULL)
+            Next = FindWork (Pool, CurrentWorker);
+        if (Next != NULL)
+            RunTask (Next);
+        else
+            sched_yield ();
+    }
+}
+
+// poolParallelFor runs the whole range as one task in the pool
+void poolParallelFor (WorkStealingPool Pool, int First, int Last, int Grain,
+                      PoolRangeFunction *Body, void *Arg)
+{
+    assert ((Pool != NULL) && (Body != NULL));
+    if (Last <= First)
+        return;
+    ForRange R;
+    R.Pool = Pool;
+    R.First = First;
+    R.Last = Last;
+    R.Grain = (Grain < 1) ? 1 : Grain;
+    R.Body = Body;
+    R.Arg = Arg;
+    poolRun (Pool, RunRange, &R);
+}
+
+// deleteWorkStealingPool tells the workers to stop, wakes them, waits for
+// each to finish and frees the pool.  It returns NULL to show the pool is
+// gone.
+WorkStealingPool deleteWorkStealingPool (WorkStealingPool Pool)
+{
+    assert ((Pool != NULL) && (Pool->Submitted == NULL));
+    pthread_mutex_lock (&Pool->Lock);
+    atomic_store (&Pool->Stopping, true);
+    pthread_cond_broadcast (&Pool->WorkSignal);
+    pthread_mutex_unlock (&Pool->Lock);
+    for (int i = 0; i < Pool->NumWorkers; i++)
+        pthread_join (Pool->Workers[i].Thread, NULL);
+    pthread_mutex_destroy (&Pool->Lock);
+    pthread_cond_destroy (&Pool->WorkSignal);
+    pthread_cond_destroy (&Pool->DoneSignal);
+    free (Pool->Workers);
+    free (Pool);
+    return NULL;
+}
+
+// PushTask stores the task at Bottom and then moves Bottom past it,
+// returning false if the deque is full.  Bottom is stored with release
+// ordering so a thief that sees the new Bottom also sees the task.
+bool PushTask (PoolWorker *W, PoolTask *T)
+{
+    long long b = atomic_load_explicit (&W->Bottom, memory_order_relaxed);
+    long long t = atomic_load_explicit (&W->Top, memory_order_acquire);
+    if (b - t >= POOLDEQUESIZE)
+        return false;
+    atomic_store_explicit (&W->Tasks[b & (POOLDEQUESIZE - 1)], T, memory_order_relaxed);
+    atomic_store_explicit (&W->Bottom, b + 1, memory_order_release);
+    return true;
+}
+
+// TakeTask claims the newest task by moving Bottom up first.  Only when
+// that leaves a single task can a thief be after it too, and then the
+// owner must win the compare-and-swap on Top to keep it.
+PoolTask *TakeTask (PoolWorker *W)
+{
+    long long b = atomic_load_explicit (&W->Bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit (&W->Bottom, b, memory_order_relaxed);
+    atomic_thread_fence (memory_order_seq_cst);
+    long long t = atomic_load_explicit (&W->Top, memory_order_relaxed);
+    PoolTask *T = NULL;
+    if (t <= b)
+    {
+        T = atomic_load_explicit (&W->Tasks[b & (POOLDEQUESIZE - 1)], memory_order_relaxed);
+        if (t == b)
+        {
+            if (!atomic_compare_exchange_strong_explicit (&W->Top, &t, t + 1,
+                                                          memory_order_seq_cst, memory_order_relaxed))
+                T = NULL;
+            atomic_store_explicit (&W->Bottom, b + 1, memory_order_relaxed);
+        }
+    }
+    else
+        atomic_store_explicit (&W->Bottom, b + 1, memory_order_relaxed);
+    return T;
+}
+
+// StealTask reads the oldest task and claims it by moving Top down past
+// it.  NULL means the deque was empty or another thread got there first.
+PoolTask *StealTask (PoolWorker *W)
+{
+    long long t = atomic_load_explicit (&W->Top, memory_order_acquire);
+    atomic_thread_fence (memory_order_seq_cst);
+    long long b = atomic_load_explicit (&W->Bottom, memory_order_acquire);
+    if (t >= b)
+        return NULL;
+    PoolTask *T = atomic_load_explicit (&W->Tasks[t & (POOLDEQUESIZE - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit (&W->Top, &t, t + 1,
+                                                  memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return T;
+}
+
+// FindWork tries to steal from every other worker once, starting at a
+// random one so that thieves spread out over their victims
+PoolTask *FindWork (WorkStealingPool Pool, int Self)
+{
+    PoolWorker *W = &Pool->Workers[Self];
+    W->Seed ^= W->Seed << 13;
+    W->Seed ^= W->Seed >> 17;
+    W->Seed ^= W->Seed << 5;
+    int Start = W->Seed % Pool->NumWorkers;
+    for (int i = 0; i < Pool->NumWorkers; i++)
+    {
+        int Victim = (Start + i) % Pool->NumWorkers;
+        if (Victim == Self)
+            continue;
+        PoolTask *T = StealTask (&Pool->Workers[Victim]);
+        if (T != NULL)
+            return T;
+    }
+    return NULL;
+}
+
+// AnyWork returns true if some worker's deque appears to hold a task
+bool AnyWork (WorkStealingPool Pool)
+{
+    for (int i = 0; i < Pool->NumWorkers; i++)
+        if (atomic_load (&Pool->Workers[i].Bottom) > atomic_load (&Pool->Workers[i].Top))
+            return true;
+    return false;
+}
+
+// RunTask runs the task and then publishes that it is done, so whoever
+// syncs with it sees everything the task wrote
+void RunTask (PoolTask *T)
+{
+    T->Run (T->Arg);
+    atomic_store_explicit (&T->Done, 1, memory_order_release);
+}
+
+// WorkerLoop is each worker thread.  It runs tasks from its own deque,
+// then stolen ones, then submitted ones.  With none of those it counts
+// itself as a sleeper, looks once more and sleeps until woken.
+void *WorkerLoop (void *Arg)
+{
+    PoolWorker *Self = (PoolWorker *) Arg;
+    WorkStealingPool Pool = Self->Pool;
+    CurrentPool = Pool;
+    CurrentWorker = (int) (Self - Pool->Workers);
+    while (!atomic_load (&Pool->Stopping))
+    {
+        PoolTask *T = TakeTask (Self);
+        if (T == NULL)
+            T = FindWork (Pool, CurrentWorker);
+        if (T != NULL)
+        {
+            RunTask (T);
+            continue;
+        }
+        pthread_mutex_lock (&Pool->Lock);
+        if (Pool->Submitted != NULL)
+        {
+            T = Pool->Submitted;
+            Pool->Submitted = T->next;
+            pthread_mutex_unlock (&Pool->Lock);
+            T->Run (T->Arg);
+            // the submitter checks Done under the lock, so it cannot miss this
+            pthread_mutex_lock (&Pool->Lock);
+            atomic_store (&T->Done, 1);
+            pthread_cond_broadcast (&Pool->DoneSignal);
+            pthread_mutex_unlock (&Pool->Lock);
+            continue;
+        }
+        atomic_fetch_add (&Pool->Sleepers, 1);
+        if (!AnyWork (Pool) && !atomic_load (&Pool->Stopping))
+            pthread_cond_wait (&Pool->WorkSignal, &Pool->Lock);
+        atomic_fetch_sub (&Pool->Sleepers, 1);
+        pthread_mutex_unlock (&Pool->Lock);
+    }
+    return NULL;
+}
+
+// RunRange handles a range no longer than Grain itself, and otherwise
+// spawns its first half and handles the second half before syncing
+void RunRange (void *Arg)
+{
+    ForRange *R = (ForRange *) Arg;
+    if (R->Last - R->First <= R->Grain)
+    {
+        R->Body (R->Arg, R->First, R->Last);
+        return;
+    }
+    int Middle = R->First + (R->Last - R->First) / 2;
+    ForRange Left = *R;
+    ForRange Right = *R;
+    Left.Last = Middle;
+    Right.First = Middle;
+    PoolTask T;
+    poolSpawn (R->Pool, &T, RunRange, &Left);
+    RunRange (&Right);
+    poolSync (R->Pool, &T);
+}
@@ -0,0 +1,102 @@
+#ifndef WORKSTEALINGPOOL_H_INCLUDED
+#define WORKSTEALINGPOOL_H_INCLUDED
+
+// WorkStealingPool is a fixed set of worker threads that run fork-join
+// tasks.  A task running in the pool can spawn a child task, go on with
+// its own work and later sync with the child, so a recursive algorithm
+// (such as a merge sort or a tree walk) can run its two halves at once.
+//
+// Each worker keeps the tasks it spawns in its own Chase-Lev deque.  The
+// worker pushes and takes tasks at the bottom of its deque without a lock,
+// while idle workers steal the oldest (and usually largest) task from the
+// top of another worker's deque.  A worker waiting in poolSync runs other
+// tasks instead of blocking, so no thread sits idle while there is work.
+//
+// The pool uses POSIX threads and C11 atomics, so compile with -std=c11
+// (or later) and link with -pthread.
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// MAXPOOLWORKERS is the most worker threads a pool may have
+#define MAXPOOLWORKERS 64
+// POOLDEQUESIZE is how many spawned tasks a worker's deque holds (a power
+// of 2).  A task spawned when the deque is full is run at once instead.
+#define POOLDEQUESIZE 4096
+
+// PoolTaskFunction is a typedef for the function a task runs.  It is
+// given the argument passed when the task was spawned.
+typedef void PoolTaskFunction (void *Arg);
+
+// PoolRangeFunction is a typedef for the body of a parallel for.  It is
+// called with the caller's argument and a range of indexes First up to
+// (but not including) Last to process.
+typedef void PoolRangeFunction (void *Arg, int First, int Last);
+
+// A PoolTask is one spawned (or submitted) piece of work.  It belongs to
+// the caller, usually as a local variable of the spawning function, and
+// must stay in place until poolSync (or poolRun) returns.  Done is set once
+// Run has returned.  next links tasks submitted from outside the pool.
+typedef struct poolTask
+{
+    PoolTaskFunction *Run;
+    void *Arg;
+    atomic_int Done;
+    struct poolTask *next;
+} PoolTask;
+
+// A PoolWorker is one worker thread of Pool and its deque.
+// Tasks[Top..Bottom-1] (indexes taken modulo POOLDEQUESIZE) are waiting to
+// run.  Top and Bottom are kept apart so thieves and the owner do not
+// share a cache line.  Seed drives the choice of which worker to steal from.
+typedef struct {
+    atomic_llong Top;
+    char Apart[64 - sizeof(atomic_llong)];
+    atomic_llong Bottom;
+    _Atomic(PoolTask *) Tasks[POOLDEQUESIZE];
+    unsigned int Seed;
+    pthread_t Thread;
+    struct workStealingPoolInfo *Pool;
+} PoolWorker;
+
+// This is the layout of a pool.  Workers holds NumWorkers workers.  Tasks
+// submitted from outside the pool wait in the Submitted list.  Idle
+// workers sleep on WorkSignal, counted in Sleepers, and threads waiting for
+// a submitted task to finish sleep on DoneSignal, all under Lock.
+typedef struct workStealingPoolInfo {
+    PoolWorker *Workers;
+    int NumWorkers;
+    PoolTask *Submitted;
+    atomic_int Sleepers;
+    atomic_bool Stopping;
+    pthread_mutex_t Lock;
+    pthread_cond_t WorkSignal;
+    pthread_cond_t DoneSignal;
+} WorkStealingPoolInfo, *WorkStealingPool;
+
+
+// initWorkStealingPool() starts a pool of NumWorkers worker threads
+WorkStealingPool initWorkStealingPool (int NumWorkers);
+// poolWorkers() returns the number of worker threads in the pool
+int         poolWorkers (WorkStealingPool Pool);
+// poolRun() runs Run(Arg) as a task in the pool and waits for it (and so
+// for everything it spawned and synced) to finish.  It is how a thread
+// outside the pool starts fork-join work.  Inside the pool it calls Run.
+void        poolRun (WorkStealingPool Pool, PoolTaskFunction *Run, void *Arg);
+// poolSpawn() makes Run(Arg) task T, which may run on any worker from now
+// until poolSync(T) returns.  It may only be called by a task in the pool.
+void        poolSpawn (WorkStealingPool Pool, PoolTask *T, PoolTaskFunction *Run, void *Arg);
+// poolSync() returns once task T has finished, running it or other tasks
+// while it waits.  Every spawned task must be synced, the most recently
+// spawned first.
+void        poolSync (WorkStealingPool Pool, PoolTask *T);
+// poolParallelFor() calls Body on ranges covering First up to Last, each
+// no more than Grain indexes long, in parallel, and returns when all are
+// done.  It may be called from inside or outside the pool.
+void        poolParallelFor (WorkStealingPool Pool, int First, int Last, int Grain,
+                             PoolRangeFunction *Body, void *Arg);
+// deleteWorkStealingPool() stops and joins the workers and frees the pool
+WorkStealingPool deleteWorkStealingPool (WorkStealingPool Pool);
+
+#endif // WORKSTEALINGPOOL_H_INCLUDED